@@ -0,0 +1,115 @@
+#include "../YAREGeX/FSM/DfaJit.hpp"
+#include "../YAREGeX/FSM/PackedDfa.hpp"
+#include <benchmark.h>
+#include <random>
+
+// Dense vs packed transition table on the same DFA: table size and scan throughput.
+// Table walk vs JIT code on a sparse DFA (words) and on a dense one (random a/b input, every state
+// continues on both bytes).
+
+static const lambda::Dfa &word_dfa()
+{
+    static const auto dfa =
+        lambda::make_dfa(lambda::make_nfa({"(h.e.l.l.o|w.o.r.l.d|q.u.i.c.k|b.r.o.w.n|f.o.x|j.u.m.p.s)*"}));
+    return dfa;
+}
+
+static const lambda::Dfa &dense_dfa()
+{
+    static const auto dfa = lambda::make_dfa(lambda::make_nfa({"(a|b)*.a.(a|b).(a|b).(a|b)"}));
+    return dfa;
+}
+
+// About 1 MiB of random a/b.
+static const std::string &dense_input()
+{
+    static const std::string input = [] {
+        std::mt19937 random{42};
+        std::string str(1 << 20, 'a');
+        for (auto &ch : str)
+        {
+            ch = "ab"[random() % 2];
+        }
+        return str;
+    }();
+    return input;
+}
+
+// About 1 MiB of words the pattern accepts.
+static const std::string &word_input()
+{
+    static const std::string input = [] {
+        const char *words[] = {"hello", "world", "quick", "brown", "fox", "jumps"};
+        std::mt19937 random{42};
+        std::string str;
+        while (str.size() < (1 << 20))
+        {
+            str += words[random() % 6];
+        }
+        return str;
+    }();
+    return input;
+}
+
+static void BM_DenseDfa(benchmark::State &state)
+{
+    auto &dfa = word_dfa();
+    auto &input = word_input();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(dfa.match(input));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+    state.counters["table_bytes"] = static_cast<double>(dfa.memory_usage());
+}
+BENCHMARK(BM_DenseDfa);
+
+static void BM_PackedDfa(benchmark::State &state)
+{
+    lambda::PackedDfa dfa(word_dfa());
+    auto &input = word_input();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(dfa.match(input));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+    state.counters["table_bytes"] = static_cast<double>(dfa.memory_usage());
+}
+BENCHMARK(BM_PackedDfa);
+
+static void BM_DfaTable_Dense(benchmark::State &state)
+{
+    auto &dfa = dense_dfa();
+    auto &input = dense_input();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(dfa.match(input));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+}
+BENCHMARK(BM_DfaTable_Dense);
+
+static void BM_DfaJit_Dense(benchmark::State &state)
+{
+    lambda::DfaJit jit(dense_dfa());
+    auto &input = dense_input();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(jit.match(input));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+}
+BENCHMARK(BM_DfaJit_Dense);
+
+// Compare with BM_DenseDfa, same DFA and input.
+static void BM_DfaJit_Words(benchmark::State &state)
+{
+    lambda::DfaJit jit(word_dfa());
+    auto &input = word_input();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(jit.match(input));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+}
+BENCHMARK(BM_DfaJit_Words);
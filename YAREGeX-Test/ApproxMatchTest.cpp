@@ -0,0 +1,103 @@
+#include "../YAREGeX/FSM/ApproxMatch.hpp"
+#include "../YAREGeX/FSM/Nfa2Dfa.hpp"
+#include "TestHelper.hpp"
+#include <gtest/gtest.h>
+
+namespace YAReGexTest
+{
+namespace ApproxMatch
+{
+
+// Reference: Levenshtein distance.
+size_t edit_distance(const std::string &lhs, const std::string &rhs)
+{
+    std::vector<size_t> row(rhs.size() + 1);
+    for (size_t col{0}; col <= rhs.size(); ++col)
+    {
+        row[col] = col;
+    }
+    for (size_t line{1}; line <= lhs.size(); ++line)
+    {
+        size_t diagonal = row[0];
+        row[0] = line;
+        for (size_t col{1}; col <= rhs.size(); ++col)
+        {
+            size_t above = row[col];
+            row[col] = std::min({row[col] + 1, row[col - 1] + 1, diagonal + (lhs[line - 1] != rhs[col - 1])});
+            diagonal = above;
+        }
+    }
+    return row[rhs.size()];
+}
+
+TEST(ApproxMatchTest, ApproxMatchTest_DistanceAgainstAcceptedStrings)
+{
+    const size_t maxErrors = 2;
+    for (auto nfa : {lambda::make_nfa({"a.(b|c)*.a"}), lambda::make_nfa({"a.b.c"}), lambda::make_nfa({"(a|b.c)*"})})
+    {
+        auto dfa = lambda::make_dfa(nfa);
+        std::vector<std::string> accepted;
+        for (auto &str : all_strings("abc", 6))
+        {
+            if (dfa.match(str))
+            {
+                accepted.push_back(str);
+            }
+        }
+        lambda::ApproxMatch approx(nfa, maxErrors);
+        for (auto &str : all_strings("abc", 4))
+        {
+            size_t best = maxErrors + 1;
+            for (auto &candidate : accepted)
+            {
+                best = std::min(best, edit_distance(str, candidate));
+            }
+            int expected = best <= maxErrors ? static_cast<int>(best) : -1;
+            EXPECT_EQ(approx.distance(str), expected) << str;
+            EXPECT_EQ(approx.match(str), expected >= 0) << str;
+        }
+    }
+}
+
+TEST(ApproxMatchTest, ApproxMatchTest_ZeroErrorsIsExact)
+{
+    auto nfa = lambda::make_nfa({"a.(a|b)*.b"});
+    auto dfa = lambda::make_dfa(nfa);
+    lambda::ApproxMatch approx(nfa, 0);
+    for (auto &str : all_strings("ab", 6))
+    {
+        EXPECT_EQ(approx.match(str), dfa.match(str)) << str;
+    }
+}
+
+TEST(ApproxMatchTest, ApproxMatchTest_Search)
+{
+    lambda::ApproxMatch approx(lambda::make_nfa({"h.e.l.l.o"}), 1);
+    EXPECT_EQ(approx.search("say hallo there"), 9u);
+    EXPECT_EQ(approx.search("say helo there"), 8u);
+    EXPECT_EQ(approx.search("say hxxo there"), lambda::ApproxMatch::npos);
+
+    lambda::ApproxMatch caseless(lambda::make_nfa({"w.o.r.l.d"}, lambda::RgxFlags::IgnoreCase), 1);
+    EXPECT_EQ(caseless.search("hello W0RLD"), 11u);
+}
+
+TEST(ApproxMatchTest, ApproxMatchTest_PositionLimit)
+{
+    std::string text{"a"}, pattern{"a"};
+    for (size_t idx{1}; idx < lambda::BitParallel::MaxPositions; ++idx)
+    {
+        text.push_back("abcd"[idx % 4]);
+        pattern += std::string(".") + text.back();
+    }
+    auto fits = lambda::make_nfa(lambda::RgxString(pattern));
+    lambda::ApproxMatch approx(fits, 1);
+    EXPECT_EQ(approx.distance(text.substr(1)), 1);
+
+    pattern += ".a";
+    auto tooLarge = lambda::make_nfa(lambda::RgxString(pattern));
+    EXPECT_FALSE(lambda::BitParallel::fits(tooLarge));
+    EXPECT_THROW(lambda::ApproxMatch(tooLarge, 1), std::length_error);
+}
+
+} // namespace ApproxMatch
+} // namespace YAReGexTest
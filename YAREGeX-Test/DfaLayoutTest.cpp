@@ -0,0 +1,121 @@
+#include "../YAREGeX/FSM/DfaLayout.hpp"
+#include "../YAREGeX/FSM/RgxPlanner.hpp"
+#include "TestHelper.hpp"
+#include <gtest/gtest.h>
+#include <sstream>
+
+namespace YAReGexTest
+{
+namespace DfaLayout
+{
+
+TEST(DfaLayoutTest, DfaLayoutTest_ReorderKeepsLanguage)
+{
+    auto dfa = lambda::make_dfa(lambda::make_nfa({"(a|b)*.a.(a|b).(a|b).(a|b)"}));
+    lambda::DfaProfile profile(dfa);
+    profile.record("bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbba");
+    auto reordered = lambda::reorder_dfa(dfa, profile);
+
+    EXPECT_TRUE(lambda::detail::same_automaton(dfa, reordered));
+    for (auto &str : all_strings("ab", 8))
+    {
+        EXPECT_EQ(reordered.match(str), dfa.match(str)) << str;
+    }
+    // the "b" loop is the hottest state
+    auto hottest = profile.hot_order().front();
+    EXPECT_EQ(hottest, dfa.next_state(dfa.start, 'b'));
+    EXPECT_EQ(reordered.next_state(reordered.start, 'b'), 0);
+}
+
+TEST(DfaLayoutTest, DfaLayoutTest_SaveLoad)
+{
+    auto dfa = lambda::make_dfa(lambda::make_nfa({"a.(b|c)*.d"}));
+    std::stringstream stream;
+    lambda::save_dfa(stream, dfa);
+
+    lambda::Dfa loaded;
+    ASSERT_TRUE(lambda::load_dfa(stream, loaded));
+    EXPECT_EQ(loaded.table, dfa.table);
+    EXPECT_EQ(loaded.accept, dfa.accept);
+    EXPECT_EQ(loaded.start, dfa.start);
+
+    auto image = stream.str();
+    std::stringstream truncated(image.substr(0, image.size() - 1));
+    EXPECT_FALSE(lambda::load_dfa(truncated, loaded));
+    image[8] = 0;
+    std::stringstream corrupted(image);
+    EXPECT_FALSE(lambda::load_dfa(corrupted, loaded));
+}
+
+TEST(DfaLayoutTest, DfaLayoutTest_ProgramLayoutPersists)
+{
+    auto program = lambda::make_program({"a.(a|b)*.b"});
+    ASSERT_EQ(program.plan().engine, lambda::RgxEngine::Dfa);
+    EXPECT_TRUE(program.train({"abbbbbbbbbbbbbbbbb", "aaaaaaaaab"}));
+    EXPECT_TRUE(program.plan().analysis.dfa_trained);
+
+    std::stringstream stream;
+    ASSERT_TRUE(program.save_layout(stream));
+    auto layout = stream.str();
+
+    auto reloaded = lambda::make_program({"a.(a|b)*.b"});
+    std::stringstream in(layout);
+    EXPECT_TRUE(reloaded.load_layout(in));
+    for (auto &str : all_strings("ab", 6))
+    {
+        EXPECT_EQ(reloaded.match(str), program.match(str)) << str;
+    }
+
+    auto other = lambda::make_program({"a.(a|b)*.a"});
+    std::stringstream wrong(layout);
+    EXPECT_FALSE(other.load_layout(wrong));
+    EXPECT_FALSE(other.plan().analysis.dfa_trained);
+
+    EXPECT_FALSE(lambda::make_program({"a.b"}).train({"ab"}));
+
+    lambda::RgxProgram malformed{lambda::RgxString(std::string("a.(b"))};
+    ASSERT_FALSE(malformed.error().empty());
+    EXPECT_FALSE(malformed.train({"ab"}));
+    EXPECT_FALSE(malformed.plan().analysis.dfa_trained);
+    std::stringstream empty;
+    EXPECT_FALSE(malformed.save_layout(empty));
+    EXPECT_TRUE(empty.str().empty());
+    std::stringstream valid(layout);
+    EXPECT_FALSE(malformed.load_layout(valid));
+    EXPECT_FALSE(malformed.match("ab"));
+}
+
+// A DFA too large for the dense table is trained through its packed form.
+TEST(DfaLayoutTest, DfaLayoutTest_PackedProgramLayout)
+{
+    std::vector<std::string> words;
+    auto pattern = word_alternation(300, words);
+    lambda::RgxProgram program{lambda::RgxString(pattern)};
+    ASSERT_EQ(program.plan().engine, lambda::RgxEngine::PackedDfa);
+    lambda::RgxProgram untrained{lambda::RgxString(pattern)};
+
+    EXPECT_TRUE(program.train({words[7] + words[7] + words[12], words[7]}));
+    EXPECT_TRUE(program.plan().analysis.dfa_trained);
+    EXPECT_EQ(program.plan().engine, lambda::RgxEngine::PackedDfa);
+
+    std::stringstream stream;
+    ASSERT_TRUE(program.save_layout(stream));
+    lambda::RgxProgram reloaded{lambda::RgxString(pattern)};
+    EXPECT_TRUE(reloaded.load_layout(stream));
+    EXPECT_TRUE(reloaded.plan().analysis.dfa_trained);
+
+    std::vector<std::string> inputs{"", words[7] + "x", words[7].substr(1)};
+    for (size_t idx{0}; idx + 1 < words.size(); idx += 13)
+    {
+        inputs.push_back(words[idx] + words[idx + 1]);
+        inputs.push_back(words[idx] + words[idx + 1].substr(1));
+    }
+    for (auto &str : inputs)
+    {
+        EXPECT_EQ(program.match(str), untrained.match(str)) << str;
+        EXPECT_EQ(reloaded.match(str), untrained.match(str)) << str;
+    }
+}
+
+} // namespace DfaLayout
+} // namespace YAReGexTest
@@ -0,0 +1,74 @@
+#include "../YAREGeX/FSM/IncrementalMatch.hpp"
+#include "TestHelper.hpp"
+#include <gtest/gtest.h>
+#include <random>
+
+namespace YAReGexTest
+{
+namespace IncrementalMatch
+{
+
+class IncrementalMatchTest : public ::testing::Test
+{
+  protected:
+    std::mt19937 m_Random{7};
+};
+
+TEST_F(IncrementalMatchTest, IncrementalMatchTest_RandomEdits)
+{
+    for (auto pattern : {lambda::make_nfa({"(a|b)*.a.b"}), lambda::make_nfa({"(a.b|b)*.(a|b*)"}),
+                         lambda::make_nfa({"a.(a|b|c)*"})})
+    {
+        auto dfa = lambda::make_dfa(pattern);
+        lambda::IncrementalMatch incremental(dfa, 16);
+        auto doc = random_string("ab", 300, m_Random);
+        EXPECT_EQ(incremental.match(doc), dfa.match(doc));
+        for (int edit{0}; edit < 500; ++edit)
+        {
+            size_t pos = m_Random() % (doc.size() + 1);
+            size_t removed = std::min<size_t>(m_Random() % 40, doc.size() - pos);
+            auto inserted = random_string(edit % 7 ? "ab" : "abc", m_Random() % 40, m_Random);
+            doc.replace(pos, removed, inserted);
+            EXPECT_EQ(incremental.rematch(doc, pos, removed, inserted.size()), dfa.match(doc)) << doc;
+        }
+    }
+}
+
+TEST_F(IncrementalMatchTest, IncrementalMatchTest_SmallEditRescansLittle)
+{
+    auto dfa = lambda::make_dfa(lambda::make_nfa({"(a|b)*.a.b"}));
+    lambda::IncrementalMatch incremental(dfa, 64);
+    auto doc = random_string("ab", 1 << 20, m_Random) + "ab";
+    EXPECT_TRUE(incremental.match(doc));
+    EXPECT_EQ(incremental.rescanned(), doc.size());
+
+    doc.replace(1000, 3, "bbbbb");
+    EXPECT_TRUE(incremental.rematch(doc, 1000, 3, 5));
+    EXPECT_TRUE(incremental.converged());
+    EXPECT_LE(incremental.rescanned(), 3 * 64u);
+
+    doc.replace(doc.size() - 1, 1, "a");
+    EXPECT_FALSE(incremental.rematch(doc, doc.size() - 1, 1, 1));
+    EXPECT_LE(incremental.rescanned(), 64u);
+}
+
+TEST_F(IncrementalMatchTest, IncrementalMatchTest_MismatchedEditScansAll)
+{
+    auto dfa = lambda::make_dfa(lambda::make_nfa({"a*"}));
+    lambda::IncrementalMatch incremental(dfa, 4);
+    EXPECT_TRUE(incremental.match("aaaaaaaa"));
+    EXPECT_TRUE(incremental.rematch("aaa", 0, 100, 0));
+    EXPECT_EQ(incremental.rescanned(), 3u);
+}
+
+TEST_F(IncrementalMatchTest, IncrementalMatchTest_OwnsDfa)
+{
+    lambda::IncrementalMatch incremental(lambda::make_dfa(lambda::make_nfa({"(a|b)*.a.b"})), 8);
+    auto doc = random_string("ab", 200, m_Random) + "ab";
+    EXPECT_TRUE(incremental.match(doc));
+    doc.replace(doc.size() - 1, 1, "a");
+    EXPECT_FALSE(incremental.rematch(doc, doc.size() - 1, 1, 1));
+}
+
+} // namespace IncrementalMatch
+} // namespace YAReGexTest
@@ -0,0 +1,52 @@
+#include "../YAREGeX/FSM/LazyDfa.hpp"
+#include "TestHelper.hpp"
+#include <gtest/gtest.h>
+
+namespace YAReGexTest
+{
+namespace LazyDfa
+{
+
+TEST(LazyDfaTest, LazyDfaTest_SameLanguageAsNfa)
+{
+    auto nfa = lambda::make_nfa({"a.(a|b)*.b|c?.d+"});
+    lambda::LazyDfa lazyDfa(nfa);
+    for (auto &str : all_strings("abcd", 6))
+    {
+        lambda::RgxMatch rgxMatch(nfa);
+        EXPECT_EQ(lazyDfa.match(str), rgxMatch.match(str)) << str;
+    }
+    EXPECT_EQ(lazyDfa.clear_count(), 0u);
+    EXPECT_FALSE(lazyDfa.gave_up());
+}
+
+TEST(LazyDfaTest, LazyDfaTest_BudgetIsRespected)
+{
+    // (a|b)*a(a|b)^n needs 2^(n+1) DFA states
+    auto nfa = lambda::make_nfa({"(a|b)*.a.(a|b).(a|b).(a|b).(a|b).(a|b).(a|b).(a|b)"});
+    const size_t budget = 2048;
+    lambda::LazyDfa lazyDfa(nfa, budget, 1000);
+    for (auto &str : all_strings("ab", 11))
+    {
+        lambda::RgxMatch rgxMatch(nfa);
+        EXPECT_EQ(lazyDfa.match(str), rgxMatch.match(str)) << str;
+        ASSERT_LE(lazyDfa.memory_usage(), budget);
+    }
+    EXPECT_GT(lazyDfa.clear_count(), 0u);
+}
+
+TEST(LazyDfaTest, LazyDfaTest_FallbackToNfa)
+{
+    auto nfa = lambda::make_nfa({"(a|b)*.a.(a|b).(a|b).(a|b).(a|b).(a|b).(a|b).(a|b)"});
+    lambda::LazyDfa lazyDfa(nfa, 2048, 2);
+    for (auto &str : all_strings("ab", 11))
+    {
+        lambda::RgxMatch rgxMatch(nfa);
+        EXPECT_EQ(lazyDfa.match(str), rgxMatch.match(str)) << str;
+    }
+    EXPECT_TRUE(lazyDfa.gave_up());
+    EXPECT_EQ(lazyDfa.memory_usage(), 0u);
+}
+
+} // namespace LazyDfa
+} // namespace YAReGexTest
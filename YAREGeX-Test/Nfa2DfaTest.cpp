@@ -0,0 +1,79 @@
+#include "../YAREGeX/FSM/DfaJit.hpp"
+#include "../YAREGeX/FSM/Nfa2Dfa.hpp"
+#include "TestHelper.hpp"
+#include <gtest/gtest.h>
+
+namespace YAReGexTest
+{
+namespace Nfa2Dfa
+{
+
+TEST(Nfa2DfaTest, Nfa2DfaTest_SameLanguageAsNfa)
+{
+    auto nfa = lambda::make_nfa({"a.(a|b)*.b"});
+    auto dfa = lambda::make_dfa(nfa);
+    ASSERT_FALSE(dfa.empty());
+    for (auto &str : all_strings("abc", 6))
+    {
+        lambda::RgxMatch rgxMatch(nfa);
+        EXPECT_EQ(dfa.match(str), rgxMatch.match(str)) << str;
+    }
+}
+
+TEST(Nfa2DfaTest, Nfa2DfaTest_StateLimit)
+{
+    auto nfa = lambda::make_nfa({"(a|b)*.a.(a|b).(a|b).(a|b).(a|b)"});
+    EXPECT_TRUE(lambda::make_dfa(nfa, 8).empty());
+    EXPECT_FALSE(lambda::make_dfa(nfa).empty());
+}
+
+TEST(Nfa2DfaTest, Nfa2DfaTest_TightStateLimit)
+{
+    // the start row alone discovers four states
+    auto nfa = lambda::make_nfa({"a.b|c.d|e.f|g.h"});
+    auto full = lambda::make_dfa(nfa).size();
+    for (size_t limit{1}; limit <= full; ++limit)
+    {
+        auto dfa = lambda::make_dfa(nfa, limit);
+        EXPECT_LE(dfa.size(), limit);
+        EXPECT_EQ(dfa.empty(), limit < full) << limit;
+    }
+}
+
+TEST(Nfa2DfaTest, DfaJitTest_SameLanguageAsDfa)
+{
+    auto nfa = lambda::make_nfa({"a.(a|b)*.b|c?.d+"});
+    auto dfa = lambda::make_dfa(nfa);
+    lambda::DfaJit jit(dfa);
+#if YAREGEX_JIT
+    EXPECT_TRUE(jit.is_compiled());
+#endif
+    for (auto &str : all_strings("abcd", 6))
+    {
+        EXPECT_EQ(jit.match(str), dfa.match(str)) << str;
+    }
+}
+
+TEST(Nfa2DfaTest, DfaJitTest_JumpTable)
+{
+    auto nfa = lambda::make_nfa({"(a|c|e|g|i|k|m|o|q|s)*.z"});
+    auto dfa = lambda::make_dfa(nfa);
+    lambda::DfaJit jit(dfa);
+    for (auto &str : all_strings("abcsz", 5))
+    {
+        EXPECT_EQ(jit.match(str), dfa.match(str)) << str;
+    }
+}
+
+TEST(Nfa2DfaTest, DfaJitTest_FallbackToInterpreter)
+{
+    auto nfa = lambda::make_nfa({"a.b.c"});
+    auto dfa = lambda::make_dfa(nfa);
+    lambda::DfaJit jit(dfa, 2);
+    EXPECT_FALSE(jit.is_compiled());
+    EXPECT_TRUE(jit.match("abc"));
+    EXPECT_FALSE(jit.match("abd"));
+}
+
+} // namespace Nfa2Dfa
+} // namespace YAReGexTest
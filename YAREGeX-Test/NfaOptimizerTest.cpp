@@ -0,0 +1,78 @@
+#include "../YAREGeX/FSM/NfaMatcher.hpp"
+#include "../YAREGeX/FSM/NfaOptimizer.hpp"
+#include "TestHelper.hpp"
+#include <chrono>
+#include <gtest/gtest.h>
+
+namespace YAReGexTest
+{
+namespace NfaOptimizer
+{
+
+// Optimized and raw programs must accept exactly the same strings.
+template <size_t N> lambda::NfaOptStats expect_same_language(const char (&pattern)[N])
+{
+    auto raw = lambda::make_nfa({pattern});
+    auto optimized = lambda::make_nfa({pattern});
+    auto stats = lambda::optimize_nfa(optimized);
+    for (auto &str : all_strings("abcd", 6))
+    {
+        lambda::RgxMatch rawMatch(raw), optimizedMatch(optimized);
+        EXPECT_EQ(optimizedMatch.match(str), rawMatch.match(str)) << pattern << " / " << str;
+    }
+    EXPECT_LE(stats.states_after, stats.states_before) << pattern;
+    return stats;
+}
+
+TEST(NfaOptimizerTest, NfaOptimizerTest_CommonPrefix)
+{
+    auto stats = expect_same_language("a.b.c|a.b.d|a.c");
+    EXPECT_EQ(stats.states_before, 11u);
+    EXPECT_EQ(stats.states_after, 7u);
+}
+
+TEST(NfaOptimizerTest, NfaOptimizerTest_CommonSuffix)
+{
+    auto stats = expect_same_language("a.b|c.b");
+    EXPECT_LT(stats.states_after, stats.states_before);
+}
+
+TEST(NfaOptimizerTest, NfaOptimizerTest_NestedClosure)
+{
+    auto stats = expect_same_language("(a*)*");
+    EXPECT_EQ(stats.splits_after, 1u);
+    expect_same_language("(a?)*.b");
+    expect_same_language("((a|b)*)*.a.(a|b)");
+}
+
+TEST(NfaOptimizerTest, NfaOptimizerTest_Loops)
+{
+    expect_same_language("(a.b|a.c)*.d");
+    expect_same_language("(a|b)*.a.(a|b).(a|b)");
+    expect_same_language("a.(a|b)*.b|c?.d+");
+    expect_same_language("a+.b+|a.c");
+}
+
+// Every pass has to stay near-linear: a few hundred words used to take seconds.
+TEST(NfaOptimizerTest, NfaOptimizerTest_LargeAlternation)
+{
+    std::vector<std::string> words;
+    lambda::RgxString postRegex(word_alternation(1000, words));
+    ASSERT_TRUE(postRegex.error().empty());
+    auto nfa = lambda::make_nfa(std::move(postRegex));
+
+    auto begin = std::chrono::steady_clock::now();
+    auto stats = lambda::optimize_nfa(nfa);
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+    EXPECT_LT(elapsed, std::chrono::seconds(5));
+    EXPECT_LT(stats.states_after, stats.states_before);
+
+    lambda::RgxMatch match(nfa);
+    EXPECT_TRUE(match.match(words[0] + words[999] + words[500]));
+    EXPECT_TRUE(match.match(""));
+    EXPECT_FALSE(match.match(words[0] + "#"));
+    EXPECT_FALSE(match.match(words[1].substr(0, 1)));
+}
+
+} // namespace NfaOptimizer
+} // namespace YAReGexTest
@@ -0,0 +1,86 @@
+#include "../YAREGeX/FSM/PackedDfa.hpp"
+#include "../YAREGeX/FSM/RgxPlanner.hpp"
+#include "TestHelper.hpp"
+#include <gtest/gtest.h>
+
+namespace YAReGexTest
+{
+namespace PackedDfa
+{
+
+TEST(PackedDfaTest, PackedDfaTest_SameTransitions)
+{
+    for (auto nfa : {lambda::make_nfa({"a.(b|c)*.d"}), lambda::make_nfa({"(a|b)*.a.(a|b).(a|b)"}),
+                     lambda::make_nfa({"(a.b|c.d|e)*"}), lambda::make_nfa({"a"})})
+    {
+        auto dfa = lambda::make_dfa(nfa);
+        lambda::PackedDfa packed(dfa);
+        ASSERT_EQ(packed.size(), dfa.size());
+        for (int32_t state{0}; state < static_cast<int32_t>(dfa.size()); ++state)
+        {
+            for (int byte{0}; byte < 256; ++byte)
+            {
+                EXPECT_EQ(packed.next_state(state, static_cast<uint8_t>(byte)),
+                          dfa.next_state(state, static_cast<uint8_t>(byte)));
+            }
+        }
+        for (auto &str : all_strings("abcde", 4))
+        {
+            EXPECT_EQ(packed.match(str), dfa.match(str)) << str;
+        }
+    }
+}
+
+TEST(PackedDfaTest, PackedDfaTest_SparseTableShrinks)
+{
+    // Many byte classes, but every state only continues on one or two of them.
+    auto dfa = lambda::make_dfa(lambda::make_nfa({"(h.e.l.l.o|w.o.r.l.d|q.u.i.c.k|b.r.o.w.n|f.o.x|j.u.m.p.s)*"}));
+    lambda::PackedDfa packed(dfa);
+    EXPECT_LT(packed.memory_usage() * 2, dfa.memory_usage());
+    EXPECT_TRUE(packed.match("helloworldfoxjumps"));
+    EXPECT_FALSE(packed.match("hellowor"));
+}
+
+TEST(PackedDfaTest, PackedDfaTest_PlannerThreshold)
+{
+    lambda::RgxPlanOptions options;
+    options.engine = lambda::RgxEngine::Dfa;
+    auto dense = lambda::make_program({"(h.e.l.l.o|w.o.r.l.d|q.u.i.c.k)*"}, options);
+    EXPECT_EQ(dense.plan().engine, lambda::RgxEngine::Dfa);
+
+    options.packed_dfa_bytes = 0;
+    auto packed = lambda::make_program({"(h.e.l.l.o|w.o.r.l.d|q.u.i.c.k)*"}, options);
+    EXPECT_EQ(packed.plan().engine, lambda::RgxEngine::PackedDfa);
+    EXPECT_LT(packed.memory_usage(), dense.memory_usage());
+    EXPECT_NE(packed.explain().find("packed to"), std::string::npos);
+    for (auto word : {"", "hello", "helloquick", "worldworld", "hell", "quickx"})
+    {
+        EXPECT_EQ(packed.match(word), dense.match(word)) << word;
+    }
+}
+
+// Auto reaches PackedDfa through the bounded large-DFA step, a small DFA never exceeds the threshold.
+TEST(PackedDfaTest, PackedDfaTest_AutoPacksLargeDfa)
+{
+    std::vector<std::string> words;
+    auto pattern = word_alternation(300, words);
+    lambda::RgxProgram packed{lambda::RgxString(pattern)};
+    EXPECT_EQ(packed.plan().engine, lambda::RgxEngine::PackedDfa);
+    EXPECT_GT(packed.plan().analysis.dfa_states, lambda::RgxPlanOptions{}.small_dfa_states);
+
+    lambda::RgxPlanOptions options;
+    options.packed_dfa_bytes = size_t{1} << 30;
+    lambda::RgxProgram dense(lambda::RgxString(pattern), options);
+    EXPECT_EQ(dense.plan().engine, lambda::RgxEngine::Dfa);
+    EXPECT_LT(packed.memory_usage(), dense.memory_usage());
+    for (size_t idx{0}; idx + 1 < words.size(); idx += 7)
+    {
+        auto str = words[idx] + words[idx + 1];
+        EXPECT_TRUE(packed.match(str)) << str;
+        str.pop_back();
+        EXPECT_EQ(packed.match(str), dense.match(str)) << str;
+    }
+}
+
+} // namespace PackedDfa
+} // namespace YAReGexTest
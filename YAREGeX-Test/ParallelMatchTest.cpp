@@ -0,0 +1,118 @@
+#include "../YAREGeX/FSM/ParallelMatch.hpp"
+#include "TestHelper.hpp"
+#include <gtest/gtest.h>
+#include <random>
+#include <thread>
+
+namespace YAReGexTest
+{
+namespace ParallelMatch
+{
+
+class ParallelMatchTest : public ::testing::Test
+{
+  protected:
+    // Reference: single-threaded walk that counts accepting prefixes.
+    uint64_t count_prefixes(const lambda::Dfa &dfa, const std::string &str)
+    {
+        uint64_t count{0};
+        int32_t state = dfa.start;
+        for (auto ch : str)
+        {
+            state = dfa.next_state(state, static_cast<uint8_t>(ch));
+            if (state == lambda::Dfa::Dead)
+            {
+                break;
+            }
+            count += dfa.is_accept(state);
+        }
+        return count;
+    }
+
+    std::mt19937 m_Random{42};
+};
+
+TEST_F(ParallelMatchTest, ParallelMatchTest_SameAsSequential)
+{
+    auto dfa = lambda::make_dfa(lambda::make_nfa({"(a|b)*.a.(a|b).(a|b)"}));
+    lambda::ParallelMatch parallel(dfa, 4, 16);
+    for (size_t size : {0, 1, 63, 64, 65, 1000, 4099})
+    {
+        auto str = random_string("ab", size, m_Random);
+        EXPECT_EQ(parallel.match(str), dfa.match(str)) << size;
+        EXPECT_EQ(parallel.count(str), count_prefixes(dfa, str)) << size;
+    }
+}
+
+TEST_F(ParallelMatchTest, ParallelMatchTest_DeadInLaterChunk)
+{
+    auto dfa = lambda::make_dfa(lambda::make_nfa({"(a|b)*"}));
+    lambda::ParallelMatch parallel(dfa, 4, 16);
+    auto str = random_string("ab", 1000, m_Random);
+    EXPECT_TRUE(parallel.match(str));
+    EXPECT_EQ(parallel.count(str), 1000u);
+    str[700] = 'c';
+    EXPECT_FALSE(parallel.match(str));
+    EXPECT_EQ(parallel.count(str), 700u);
+}
+
+TEST_F(ParallelMatchTest, ParallelMatchTest_Speculation)
+{
+    auto dfa = lambda::make_dfa(lambda::make_nfa({"(a|b)*.a.(a|b).(a|b).(a|b)"}));
+    lambda::ParallelMatch parallel(dfa, 8, 16, 1);
+    for (size_t size : {100, 1000, 5000})
+    {
+        auto str = random_string("ab", size, m_Random);
+        EXPECT_EQ(parallel.match(str), dfa.match(str)) << size;
+        EXPECT_EQ(parallel.count(str), count_prefixes(dfa, str)) << size;
+    }
+}
+
+// The matcher owns its table, so it can be built from a temporary, and queries may overlap.
+TEST_F(ParallelMatchTest, ParallelMatchTest_ConcurrentQueries)
+{
+    lambda::ParallelMatch parallel(lambda::make_dfa(lambda::make_nfa({"(a|b)*.a.(a|b).(a|b).(a|b)"})), 4, 16, 1);
+    auto reference = lambda::make_dfa(lambda::make_nfa({"(a|b)*.a.(a|b).(a|b).(a|b)"}));
+    std::vector<std::string> inputs;
+    for (size_t idx{0}; idx < 4; ++idx)
+    {
+        inputs.push_back(random_string("ab", 2000 + idx, m_Random));
+    }
+    std::vector<uint64_t> counts(inputs.size());
+    std::vector<std::thread> queries;
+    for (size_t idx{0}; idx < inputs.size(); ++idx)
+    {
+        queries.emplace_back([&, idx] { counts[idx] = parallel.count(inputs[idx]); });
+    }
+    for (auto &query : queries)
+    {
+        query.join();
+    }
+    for (size_t idx{0}; idx < inputs.size(); ++idx)
+    {
+        EXPECT_EQ(counts[idx], count_prefixes(reference, inputs[idx])) << idx;
+    }
+    EXPECT_LE(parallel.mispredictions(), 3u);
+}
+
+// Every byte moves every state to the next one, so paths started from different states never meet. The
+// chunks must not keep scanning from all of them.
+TEST_F(ParallelMatchTest, ParallelMatchTest_PathsNeverMerge)
+{
+    auto dfa = lambda::make_dfa(lambda::make_nfa({"((a|b).(a|b).(a|b).(a|b).(a|b).(a|b).(a|b).(a|b))*"}));
+    ASSERT_EQ(dfa.size(), 8u);
+    const unsigned threads{8};
+    lambda::ParallelMatch parallel(dfa, threads, 16);
+    for (size_t size : {4096, 65536, 65539})
+    {
+        auto str = random_string("ab", size, m_Random);
+        EXPECT_EQ(parallel.match(str), dfa.match(str)) << size;
+        EXPECT_EQ(parallel.count(str), count_prefixes(dfa, str)) << size;
+        // the speculated start and guess paths, plus every state for the first ConvergeBytes of each chunk
+        EXPECT_LE(parallel.transitions(), 2 * size + threads * lambda::ParallelMatch::ConvergeBytes * dfa.size())
+            << size;
+    }
+}
+
+} // namespace ParallelMatch
+} // namespace YAReGexTest
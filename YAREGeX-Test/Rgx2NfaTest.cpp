@@ -1,9 +1,67 @@
-#include "../YAREGeX/yaregex_common.h"
+#include "../YAREGeX/FSM/DfaJit.hpp"
+#include "../YAREGeX/FSM/NfaMatcher.hpp"
+#include "../YAREGeX/FSM/RgxPlanner.hpp"
+#include "TestHelper.hpp"
 #include <gtest/gtest.h>
 namespace YAReGexTest
 {
 namespace Rgx2NfaTest
 {
 
+TEST(Rgx2NfaTest, Rgx2NfaTest_UpperCaseLetters)
+{
+    auto nfa = lambda::make_nfa({"A.b*"});
+    lambda::RgxMatch rgxMatch(nfa);
+    EXPECT_TRUE(rgxMatch.match("Abb"));
+    EXPECT_FALSE(rgxMatch.match("abb"));
+}
+
+TEST(Rgx2NfaTest, Rgx2NfaTest_IgnoreCase)
+{
+    auto nfa = lambda::make_nfa({"a.(B|c)*.d"}, lambda::RgxFlags::IgnoreCase);
+    auto dfa = lambda::make_dfa(nfa);
+    lambda::DfaJit jit(dfa);
+    lambda::BitParallel bitParallel(nfa);
+    for (auto &str : all_strings("aBcDAbCd", 4))
+    {
+        std::string lower;
+        for (auto ch : str)
+        {
+            lower.push_back(static_cast<char>(ch | 0x20));
+        }
+        auto expected = lambda::make_dfa(lambda::make_nfa({"a.(b|c)*.d"})).match(lower);
+        lambda::RgxMatch rgxMatch(nfa);
+        EXPECT_EQ(rgxMatch.match(str), expected) << str;
+        EXPECT_EQ(dfa.match(str), expected) << str;
+        EXPECT_EQ(jit.match(str), expected) << str;
+        EXPECT_EQ(bitParallel.match(str), expected) << str;
+    }
+}
+
+TEST(Rgx2NfaTest, Rgx2NfaTest_IgnoreCaseSharesByteClass)
+{
+    auto dfa = lambda::make_dfa(lambda::make_nfa({"a.b"}, lambda::RgxFlags::IgnoreCase));
+    EXPECT_EQ(dfa.byte_class['a'], dfa.byte_class['A']);
+    EXPECT_EQ(dfa.byte_class['b'], dfa.byte_class['B']);
+    EXPECT_EQ(dfa.class_count, 3u);
+}
+
+TEST(Rgx2NfaTest, Rgx2NfaTest_IgnoreCaseLiteral)
+{
+    lambda::RgxPlanOptions options;
+    options.flags = lambda::RgxFlags::IgnoreCase;
+    auto program = lambda::make_program({"a.b.c"}, options);
+    EXPECT_EQ(program.plan().engine, lambda::RgxEngine::Literal);
+    EXPECT_TRUE(program.match("aBC"));
+    EXPECT_FALSE(program.match("aBD"));
+}
+
+TEST(Rgx2NfaTest, Rgx2NfaTest_HighBytesDoNotMatch)
+{
+    auto nfa = lambda::make_nfa({"a*"});
+    lambda::RgxMatch rgxMatch(nfa);
+    EXPECT_FALSE(rgxMatch.match("\xFF"));
+}
+
 } // namespace Rgx2NfaTest
 } // namespace YAReGexTest
@@ -0,0 +1,128 @@
+#include "../YAREGeX/FSM/RgxBulk.hpp"
+#include "TestHelper.hpp"
+#include <gtest/gtest.h>
+
+namespace YAReGexTest
+{
+namespace RgxBulk
+{
+
+TEST(RgxBulkTest, RgxBulkTest_RuntimePattern)
+{
+    lambda::RgxString postRegex(std::string("a.(a|b)*.b"));
+    EXPECT_TRUE(postRegex.error().empty());
+    std::string postfix(postRegex.begin(), postRegex.end());
+    lambda::RgxString literal("a.(a|b)*.b");
+    EXPECT_EQ(postfix, std::string(literal.begin(), literal.end()));
+}
+
+TEST(RgxBulkTest, RgxBulkTest_PerPatternErrors)
+{
+    std::vector<std::string> patterns{"a.b", "a|", "(a.b", "a.b)", "", "a(b)", "a.1", "b*"};
+    auto results = lambda::compile_all(patterns, {}, 3);
+    ASSERT_EQ(results.size(), patterns.size());
+    EXPECT_TRUE(results[0].ok());
+    EXPECT_EQ(results[1].error, "missing operand for '|'");
+    EXPECT_EQ(results[2].error, "unbalanced '('");
+    EXPECT_EQ(results[3].error, "unbalanced ')'");
+    EXPECT_EQ(results[4].error, "empty pattern");
+    EXPECT_EQ(results[5].error, "missing operator, concatenation is written as '.'");
+    EXPECT_EQ(results[6].error, "unsupported character '1' at 2");
+    EXPECT_TRUE(results[7].ok());
+    EXPECT_TRUE(results[7].program->match("bbb"));
+}
+
+TEST(RgxBulkTest, RgxBulkTest_SameAsSequential)
+{
+    std::vector<std::string> patterns;
+    for (auto &word : all_strings("abc", 3))
+    {
+        if (word.empty())
+        {
+            continue;
+        }
+        std::string pattern;
+        for (auto ch : word)
+        {
+            pattern += pattern.empty() ? std::string(1, ch) : std::string(".") + ch;
+        }
+        patterns.push_back("(" + pattern + ")*.(a|c)");
+        patterns.push_back("(a|b)*." + pattern);
+    }
+    auto sequential = lambda::compile_all(patterns, {}, 1);
+    auto parallel = lambda::compile_all(patterns, {}, 4);
+    ASSERT_EQ(parallel.size(), patterns.size());
+    auto inputs = all_strings("abc", 5);
+    for (size_t idx{0}; idx < patterns.size(); ++idx)
+    {
+        ASSERT_TRUE(parallel[idx].ok()) << patterns[idx] << ": " << parallel[idx].error;
+        EXPECT_EQ(parallel[idx].program->plan().engine, sequential[idx].program->plan().engine);
+        for (auto &input : inputs)
+        {
+            EXPECT_EQ(parallel[idx].program->match(input), sequential[idx].program->match(input))
+                << patterns[idx] << " / " << input;
+        }
+    }
+}
+
+TEST(RgxBulkTest, RgxBulkTest_ArenaScope)
+{
+    auto arena = std::make_shared<lambda::Arena>();
+    lambda::StatePtr_t nfa;
+    {
+        lambda::Arena::Scope scope(arena);
+        nfa = lambda::make_nfa({"a.(a|b)*.b"});
+    }
+    EXPECT_GT(arena->bytes_allocated(), 0u);
+    EXPECT_EQ(lambda::Arena::current(), nullptr);
+    lambda::RgxMatch rgxMatch(nfa);
+    EXPECT_TRUE(rgxMatch.match("abab"));
+}
+
+// Loops make NFA states own each other, the program has to cut them or the arena is never released.
+TEST(RgxBulkTest, RgxBulkTest_ArenaReleased)
+{
+    auto arena = std::make_shared<lambda::Arena>();
+    std::weak_ptr<lambda::Arena> weak = arena;
+    std::unique_ptr<lambda::RgxProgram> program;
+    {
+        lambda::Arena::Scope scope(std::move(arena));
+        program = std::make_unique<lambda::RgxProgram>(lambda::RgxString(std::string("(a.b)*.a+")));
+    }
+    EXPECT_TRUE(program->match("ababaa"));
+    EXPECT_FALSE(weak.expired());
+    program.reset();
+    EXPECT_TRUE(weak.expired());
+
+    // every state compile_all allocated is freed with the results, so are the per-thread arenas
+    std::vector<std::weak_ptr<lambda::State>> states;
+    {
+        auto results = lambda::compile_all({"(a|b)*.a", "a+.b?", "(a*)*", "a.b.c"}, {}, 2);
+        for (auto &result : results)
+        {
+            ASSERT_TRUE(result.ok());
+            for (auto &state : lambda::detail::collect_states(result.program->nfa()))
+            {
+                states.emplace_back(state);
+            }
+        }
+    }
+    ASSERT_FALSE(states.empty());
+    for (auto &state : states)
+    {
+        EXPECT_TRUE(state.expired());
+    }
+}
+
+TEST(RgxBulkTest, RgxBulkTest_ProgramError)
+{
+    lambda::RgxProgram program{lambda::RgxString(std::string("a.(b"))};
+    EXPECT_EQ(program.error(), "unbalanced '('");
+    EXPECT_NE(program.explain().find("invalid pattern"), std::string::npos);
+    EXPECT_FALSE(program.match("ab"));
+    EXPECT_FALSE(program.match(""));
+    EXPECT_TRUE(lambda::make_program({"a.b"}).error().empty());
+}
+
+} // namespace RgxBulk
+} // namespace YAReGexTest
@@ -0,0 +1,161 @@
+#include "../YAREGeX/FSM/RgxPlanner.hpp"
+#include "TestHelper.hpp"
+#include <chrono>
+#include <gtest/gtest.h>
+
+namespace YAReGexTest
+{
+namespace RgxPlanner
+{
+
+// Every engine the planner can pick has to agree with RgxMatch.
+template <size_t N> void expect_engines_agree(const char (&pattern)[N])
+{
+    auto nfa = lambda::make_nfa({pattern});
+    for (auto engine : {lambda::RgxEngine::Auto, lambda::RgxEngine::Literal, lambda::RgxEngine::Dfa,
+                        lambda::RgxEngine::PackedDfa, lambda::RgxEngine::BitParallel, lambda::RgxEngine::LazyDfa,
+                        lambda::RgxEngine::Nfa})
+    {
+        lambda::RgxPlanOptions options;
+        options.engine = engine;
+        auto program = lambda::make_program({pattern}, options);
+        for (auto &str : all_strings("abcd", 6))
+        {
+            lambda::RgxMatch rgxMatch(nfa);
+            EXPECT_EQ(program.match(str), rgxMatch.match(str))
+                << pattern << " / " << str << " / " << lambda::engine_name(program.plan().engine);
+        }
+    }
+}
+
+TEST(RgxPlannerTest, RgxPlannerTest_Literal)
+{
+    auto program = lambda::make_program({"a.b.c"});
+    EXPECT_EQ(program.plan().engine, lambda::RgxEngine::Literal);
+    EXPECT_EQ(program.plan().analysis.literal_text, "abc");
+    EXPECT_TRUE(program.match("abc"));
+    EXPECT_FALSE(program.match("abcd"));
+}
+
+TEST(RgxPlannerTest, RgxPlannerTest_SmallDfa)
+{
+    auto program = lambda::make_program({"a.(a|b)*.b"});
+    EXPECT_EQ(program.plan().engine, lambda::RgxEngine::Dfa);
+    EXPECT_TRUE(program.plan().analysis.anchored);
+    EXPECT_FALSE(program.plan().analysis.captures);
+}
+
+TEST(RgxPlannerTest, RgxPlannerTest_DfaBlowUp)
+{
+    auto program = lambda::make_program({"(a|b)*.a.(a|b).(a|b).(a|b).(a|b).(a|b).(a|b)"});
+    EXPECT_EQ(program.plan().engine, lambda::RgxEngine::BitParallel);
+    EXPECT_NE(program.explain().find("BitParallel"), std::string::npos);
+}
+
+TEST(RgxPlannerTest, RgxPlannerTest_BitParallelLimit)
+{
+    std::string pattern{"a"};
+    for (size_t idx{1}; idx < lambda::BitParallel::MaxPositions + 1; ++idx)
+    {
+        pattern += std::string(".") + "abcd"[idx % 4];
+    }
+    auto nfa = lambda::make_nfa(lambda::RgxString(pattern));
+    EXPECT_EQ(lambda::BitParallel::positions(nfa), lambda::BitParallel::MaxPositions + 1);
+    EXPECT_THROW(lambda::BitParallel{nfa}, std::length_error);
+
+    lambda::RgxPlanOptions options;
+    options.engine = lambda::RgxEngine::BitParallel;
+    lambda::RgxProgram program(lambda::RgxString(pattern), options);
+    EXPECT_NE(program.plan().engine, lambda::RgxEngine::BitParallel);
+}
+
+TEST(RgxPlannerTest, RgxPlannerTest_LargeDfa)
+{
+    std::vector<std::string> words;
+    auto pattern = word_alternation(300, words);
+    lambda::RgxPlanOptions options;
+    options.packed_dfa_bytes = size_t{1} << 30;
+    lambda::RgxProgram program(lambda::RgxString(pattern), options);
+    EXPECT_GT(program.plan().analysis.positions, lambda::BitParallel::MaxPositions);
+    EXPECT_EQ(program.plan().engine, lambda::RgxEngine::Dfa);
+    EXPECT_GT(program.plan().analysis.dfa_states, options.small_dfa_states);
+    EXPECT_LE(program.plan().analysis.dfa_states, options.max_dfa_states);
+    EXPECT_TRUE(program.match(words[3] + words[299]));
+    EXPECT_FALSE(program.match(words[3] + "a"));
+
+    // max_dfa_states still bounds the eager construction under Auto
+    options.max_dfa_states = program.plan().analysis.dfa_states - 1;
+    lambda::RgxProgram bounded(lambda::RgxString(pattern), options);
+    EXPECT_EQ(bounded.plan().engine, lambda::RgxEngine::LazyDfa);
+    EXPECT_NE(bounded.explain().find("exceeded"), std::string::npos);
+    EXPECT_TRUE(bounded.match(words[3] + words[299]));
+}
+
+// The eager DFA attempt under Auto is bounded by the cache budget too, not only by max_dfa_states.
+TEST(RgxPlannerTest, RgxPlannerTest_EagerDfaWithinBudget)
+{
+    std::string any{"(a"};
+    for (char ch{'b'}; ch <= 'z'; ++ch)
+    {
+        any += std::string("|") + ch;
+    }
+    any += ")";
+    std::string pattern = any + "*.a";
+    for (size_t idx{0}; idx < 14; ++idx)
+    {
+        pattern += "." + any;
+    }
+    lambda::RgxPlanOptions options;
+    options.dfa_cache_budget = 64 * 1024;
+
+    auto begin = std::chrono::steady_clock::now();
+    lambda::RgxProgram program(lambda::RgxString(pattern), options);
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+    EXPECT_EQ(program.plan().engine, lambda::RgxEngine::LazyDfa);
+    EXPECT_NE(program.explain().find("65536 bytes"), std::string::npos);
+    EXPECT_LT(elapsed, std::chrono::milliseconds(500));
+    EXPECT_LE(program.lazy_dfa()->memory_usage(), options.dfa_cache_budget);
+    EXPECT_TRUE(program.match("xa" + std::string(14, 'q')));
+    EXPECT_FALSE(program.match("xb" + std::string(14, 'q')));
+}
+
+TEST(RgxPlannerTest, RgxPlannerTest_MemoryBudget)
+{
+    lambda::RgxPlanOptions options;
+    options.max_dfa_states = 256;
+    options.dfa_cache_budget = 4096;
+    auto program = lambda::make_program({"(a|b)*.a.(a|b).(a|b).(a|b).(a|b).(a|b).(a|b).(a|b).(a|b)."
+                                         "a.b.c.d.a.b.c.d.a.b.c.d.a.b.c.d.a.b.c.d.a.b.c.d.a.b.c.d.a.b.c.d.a.b.c.d."
+                                         "a.b.c.d.a.b.c.d.a.b.c.d"},
+                                        options);
+    EXPECT_EQ(program.plan().engine, lambda::RgxEngine::LazyDfa);
+    auto baseline = program.memory_usage();
+    for (auto &str : all_strings("ab", 12))
+    {
+        program.match(str);
+        EXPECT_LE(program.memory_usage(), baseline + options.dfa_cache_budget);
+    }
+}
+
+TEST(RgxPlannerTest, RgxPlannerTest_Override)
+{
+    lambda::RgxPlanOptions options;
+    options.engine = lambda::RgxEngine::Nfa;
+    auto program = lambda::make_program({"a.b.c"}, options);
+    EXPECT_EQ(program.plan().engine, lambda::RgxEngine::Nfa);
+
+    options.engine = lambda::RgxEngine::Literal;
+    auto fallback = lambda::make_program({"a*"}, options);
+    EXPECT_EQ(fallback.plan().requested, lambda::RgxEngine::Literal);
+    EXPECT_NE(fallback.plan().engine, lambda::RgxEngine::Literal);
+}
+
+TEST(RgxPlannerTest, RgxPlannerTest_EnginesAgree)
+{
+    expect_engines_agree("a.b.c");
+    expect_engines_agree("a.(a|b)*.b|c?.d+");
+    expect_engines_agree("(a|b)*.a.(a|b).(a|b)");
+}
+
+} // namespace RgxPlanner
+} // namespace YAReGexTest
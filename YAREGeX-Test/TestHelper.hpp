@@ -0,0 +1,59 @@
+#pragma once
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace YAReGexTest
+{
+
+// Every string over alphabet up to length maxLen, used to compare engines exhaustively.
+inline std::vector<std::string> all_strings(const std::string &alphabet, size_t maxLen)
+{
+    std::vector<std::string> result{""};
+    for (size_t begin{0}; begin < result.size(); ++begin)
+    {
+        if (result[begin].size() == maxLen)
+        {
+            continue;
+        }
+        for (auto ch : alphabet)
+        {
+            result.push_back(result[begin] + ch);
+        }
+    }
+    return result;
+}
+
+// Random string of size characters drawn from alphabet.
+inline std::string random_string(const std::string &alphabet, size_t size, std::mt19937 &random)
+{
+    std::string str;
+    for (size_t idx{0}; idx < size; ++idx)
+    {
+        str.push_back(alphabet[random() % alphabet.size()]);
+    }
+    return str;
+}
+
+// Pattern (w1|w2|...)* over count random lowercase words of 4 to 9 letters, written for RgxString with '.'
+// between the letters. The words go to words.
+inline std::string word_alternation(size_t count, std::vector<std::string> &words)
+{
+    std::mt19937 random(1);
+    std::string pattern;
+    for (size_t idx{0}; idx < count; ++idx)
+    {
+        std::string word, postfix;
+        for (size_t len = 4 + random() % 6; word.size() < len;)
+        {
+            word += static_cast<char>('a' + random() % 26);
+            postfix += (postfix.empty() ? "" : ".") + word.substr(word.size() - 1);
+        }
+        words.push_back(word);
+        pattern += (pattern.empty() ? "" : "|") + postfix;
+    }
+    return "(" + pattern + ")*";
+}
+
+} // namespace YAReGexTest
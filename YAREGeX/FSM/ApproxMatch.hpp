@@ -0,0 +1,136 @@
+#pragma once
+
+/**
+ * Approximate matching with up to k errors
+ * Accepts input that is within k insertions, deletions or substitutions of some string of the pattern. Runs
+ * k + 1 active sets of the bit-parallel engine side by side, set i holding the states reachable with i errors,
+ * so a step costs k + 1 table walks no matter how many variants of the pattern the errors allow.
+ * For detail see: Wu & Manber, Fast Text Searching Allowing Errors (CACM 1992) and
+ *                 Navarro & Raffinot, Flexible Pattern Matching in Strings (Chapter 6.2).
+ *
+ * Author   : Bora Ilgar
+ * Version  : 0.9.1
+ */
+
+#include "../utility/yaregex_common.h"
+#include "BitParallel.hpp"
+
+// With D[i] the active set after i errors and D'[i] the set after reading byte c:
+//
+//     D'[0] = Follow(D[0] & B[c])
+//     D'[i] = Follow(D[i] & B[c])   match
+//           | D[i-1]                insertion    : c is consumed, the pattern does not move
+//           | Follow(D[i-1])        substitution : any char state consumes c
+//           | Follow(D'[i-1])       deletion     : a pattern char is skipped without reading input
+//
+// Follow distributes over OR, so the three Follow terms are one walk of the follow table per level.
+// D[i] always contains D[i-1], so checking the match bit of D[k] is enough.
+
+namespace lambda
+{
+
+struct ApproxMatch
+{
+    using Mask_t = BitParallel::Mask_t;
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    // Same limit as BitParallel: the pattern has to fit in BitParallel::MaxPositions positions, the engine
+    // member throws std::length_error otherwise (check BitParallel::fits first to avoid it).
+    ApproxMatch(const StatePtr_t &start, size_t maxErrors)
+        : m_Engine(start), m_MaxErrors(maxErrors), m_Initial(maxErrors + 1), m_Active(maxErrors + 1),
+          m_Next(maxErrors + 1)
+    {
+        // Deleting the first i pattern chars is the only way to spend errors before reading input.
+        m_Initial[0] = m_Engine.start();
+        for (size_t level{1}; level <= m_MaxErrors; ++level)
+        {
+            m_Initial[level] = m_Initial[level - 1] | m_Engine.follow(m_Initial[level - 1]);
+        }
+    }
+
+    size_t max_errors() const
+    {
+        return m_MaxErrors;
+    }
+
+    // Whole-string match, like RgxMatch::match, allowing up to max_errors() errors.
+    bool match(const std::string &checkStr)
+    {
+#ifdef LDEBUG
+        PROFILE_FUNCTION();
+#endif
+        return distance(checkStr) >= 0;
+    }
+
+    // Fewest errors checkStr can be matched with as a whole, -1 if more than max_errors() are needed.
+    int distance(const std::string &checkStr)
+    {
+#ifdef LDEBUG
+        PROFILE_FUNCTION();
+#endif
+        m_Active = m_Initial;
+        for (auto ch : checkStr)
+        {
+            step(static_cast<uint8_t>(ch));
+            if (!m_Active[m_MaxErrors])
+            {
+                return -1;
+            }
+        }
+        for (size_t level{0}; level <= m_MaxErrors; ++level)
+        {
+            if (m_Active[level] & BitParallel::MatchBit)
+            {
+                return static_cast<int>(level);
+            }
+        }
+        return -1;
+    }
+
+    // Unanchored search: end offset of the first substring of checkStr matched with up to max_errors() errors,
+    // npos if there is none. An occurrence may start anywhere, so the initial sets are added back before every byte.
+    size_t search(const std::string &checkStr)
+    {
+#ifdef LDEBUG
+        PROFILE_FUNCTION();
+#endif
+        m_Active = m_Initial;
+        if (m_Active[m_MaxErrors] & BitParallel::MatchBit)
+        {
+            return 0;
+        }
+        for (size_t idx{0}; idx < checkStr.size(); ++idx)
+        {
+            for (size_t level{0}; level <= m_MaxErrors; ++level)
+            {
+                m_Active[level] |= m_Initial[level];
+            }
+            step(static_cast<uint8_t>(checkStr[idx]));
+            if (m_Active[m_MaxErrors] & BitParallel::MatchBit)
+            {
+                return idx + 1;
+            }
+        }
+        return npos;
+    }
+
+  private:
+    void step(uint8_t byte)
+    {
+        auto mask = m_Engine.byte_mask(byte);
+        m_Next[0] = m_Engine.follow(m_Active[0] & mask);
+        for (size_t level{1}; level <= m_MaxErrors; ++level)
+        {
+            m_Next[level] = m_Engine.follow((m_Active[level] & mask) | m_Active[level - 1] | m_Next[level - 1]) |
+                            m_Active[level - 1];
+        }
+        m_Active.swap(m_Next);
+    }
+
+  private:
+    BitParallel m_Engine;
+    size_t m_MaxErrors;
+    std::vector<Mask_t> m_Initial, m_Active, m_Next;
+};
+
+} // namespace lambda
@@ -0,0 +1,151 @@
+#pragma once
+
+/**
+ * Bit-parallel NFA simulation
+ * Every char state of the NFA gets one bit of a 64 bit word, so the whole current list of RgxMatch
+ * fits in a register and one step is a handful of AND/OR operations instead of add_state calls.
+ * For detail see: Navarro & Raffinot, Flexible Pattern Matching in Strings (Chapter 5, Glushkov automaton).
+ *
+ * Author   : Bora Ilgar
+ * Version  : 0.9.1
+ */
+
+#include "../utility/yaregex_common.h"
+#include "Rgx2Nfa.hpp"
+
+// Active set D holds the char states the NFA is waiting in (the current list of RgxMatch).
+// Reading byte c keeps the states labelled c and moves them to the closure of their next0:
+//
+//     D' = Follow(D & B[c])
+//
+// B[c]   : char states labelled c
+// Follow : union of closure(next0) over the set bits, looked up eight bits at a time
+// Bit 63 stands for the match-state, it is never labelled so it drops out on the next step.
+
+namespace lambda
+{
+
+struct BitParallel
+{
+    using Mask_t = uint64_t;
+    static constexpr size_t MaxPositions = 63;
+    static constexpr Mask_t MatchBit = Mask_t{1} << 63;
+
+    // Number of bits the NFA needs, the engine can be used if it is not above MaxPositions.
+    static size_t positions(const StatePtr_t &start)
+    {
+        auto states = detail::collect_states(start);
+        return static_cast<size_t>(std::count_if(states.begin(), states.end(),
+                                                 [](const StatePtr_t &state) { return detail::is_char_state(state.get()); }));
+    }
+
+    static bool fits(const StatePtr_t &start)
+    {
+        return positions(start) <= MaxPositions;
+    }
+
+    // Throws std::length_error if the NFA does not fit, see fits.
+    BitParallel(const StatePtr_t &start)
+    {
+        if (!fits(start))
+        {
+            throw std::length_error("BitParallel: more than 63 char states");
+        }
+        std::map<State *, int> bitOf;
+        std::vector<State *> charStates;
+        for (auto &state : detail::collect_states(start))
+        {
+            if (detail::is_char_state(state.get()))
+            {
+                bitOf[state.get()] = static_cast<int>(charStates.size());
+                charStates.push_back(state.get());
+            }
+        }
+
+        auto to_mask = [&](const std::vector<State *> &closure) {
+            Mask_t mask{0};
+            for (auto state : closure)
+            {
+                mask |= detail::is_char_state(state) ? Mask_t{1} << bitOf[state] : MatchBit;
+            }
+            return mask;
+        };
+
+        std::array<Mask_t, 64> follow{};
+        for (size_t bit{0}; bit < charStates.size(); ++bit)
+        {
+            follow[bit] = to_mask(detail::closure({charStates[bit]->next0.get()}));
+            m_ByteMask[static_cast<uint8_t>(charStates[bit]->ch)] |= Mask_t{1} << bit;
+            if (charStates[bit]->fold >= 0)
+            {
+                m_ByteMask[static_cast<uint8_t>(charStates[bit]->fold)] |= Mask_t{1} << bit;
+            }
+        }
+        m_Start = to_mask(detail::closure({start.get()}));
+
+        for (size_t chunk{0}; chunk < m_Follow.size(); ++chunk)
+        {
+            for (size_t byte{0}; byte < 256; ++byte)
+            {
+                for (size_t bit{0}; bit < 8; ++bit)
+                {
+                    if (byte & (size_t{1} << bit))
+                    {
+                        m_Follow[chunk][byte] |= follow[chunk * 8 + bit];
+                    }
+                }
+            }
+        }
+    }
+
+    Mask_t start() const
+    {
+        return m_Start;
+    }
+
+    Mask_t follow(Mask_t active) const
+    {
+        Mask_t next{0};
+        for (size_t chunk{0}; active; ++chunk, active >>= 8)
+        {
+            next |= m_Follow[chunk][active & 0xFF];
+        }
+        return next;
+    }
+
+    // Char states labelled byte.
+    Mask_t byte_mask(uint8_t byte) const
+    {
+        return m_ByteMask[byte];
+    }
+
+    Mask_t step(Mask_t active, uint8_t byte) const
+    {
+        return follow(active & m_ByteMask[byte]);
+    }
+
+    // Same semantics as RgxMatch::match: the whole string has to be accepted.
+    bool match(const std::string &checkStr) const
+    {
+#ifdef LDEBUG
+        PROFILE_FUNCTION();
+#endif
+        Mask_t active = m_Start;
+        for (auto ch : checkStr)
+        {
+            active = step(active, static_cast<uint8_t>(ch));
+            if (!active)
+            {
+                return false;
+            }
+        }
+        return (active & MatchBit) != 0;
+    }
+
+  private:
+    std::array<Mask_t, 256> m_ByteMask{};
+    std::array<std::array<Mask_t, 256>, 8> m_Follow{};
+    Mask_t m_Start{0};
+};
+
+} // namespace lambda
@@ -0,0 +1,329 @@
+#pragma once
+
+/**
+ * x86-64 JIT compiler for DFA matching loops
+ * Translates the transition table created by make_dfa into native code: every DFA state becomes a
+ * code block that loads one byte and branches to the block of the next state.
+ * Falls back to the table interpreter (Dfa::match) when native code can not be generated.
+ * The branches only pay off when they are predictable: on sparse DFAs whose states mostly take one
+ * transition (word lists, literals with loops) it is about 1.5x faster than the table walk, on dense DFAs
+ * fed unpredictable input ((a|b)*.a.(a|b).(a|b) over random a/b) the compare chain mispredicts and the
+ * table walk is about 1.4x faster. See BM_DfaJit_* in GoogleBenchmark/BM_Dfa.cpp.
+ *
+ * Author   : Bora Ilgar
+ * Version  : 0.9.1
+ */
+
+#include "../utility/yaregex_common.h"
+#include "Nfa2Dfa.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define YAREGEX_JIT 1
+#else
+#define YAREGEX_JIT 0
+#endif
+
+#if YAREGEX_JIT
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#endif
+
+// Layout of the generated code (r8 = current byte pointer, r9 = end of input):
+//
+// state_i:  cmp r8, r9                 ; input exhausted?
+//           jb  load_i
+//           mov eax, accept[i]
+//           ret
+// load_i:   movzx eax, byte [r8]
+//           inc r8
+//           cmp eax, 'x' / je state_k  ; a compare-and-branch per byte range,
+//           ...                        ; or an indirect jump through a 256 entry table
+//           jmp state_default          ; the most frequent target needs no compare at all
+// fail:     xor eax, eax
+//           ret
+
+namespace lambda
+{
+
+struct DfaJit
+{
+    // Above this many states the generated code stops fitting in the instruction cache,
+    // and the table interpreter is the faster of the two.
+    static constexpr size_t MaxStates = 1024;
+    // States with more byte ranges than this are dispatched through a jump table.
+    static constexpr size_t MaxCompares = 8;
+
+    DfaJit(const Dfa &dfa, size_t maxStates = MaxStates) : m_Dfa(dfa)
+    {
+#if YAREGEX_JIT
+        if (!m_Dfa.empty() && m_Dfa.size() <= maxStates)
+        {
+            compile();
+        }
+#endif
+    }
+
+    DfaJit(const DfaJit &) = delete;
+    DfaJit &operator=(const DfaJit &) = delete;
+
+    ~DfaJit()
+    {
+        release();
+    }
+
+    // True if match runs native code, false if it interprets the table.
+    bool is_compiled() const
+    {
+        return m_Fn != nullptr;
+    }
+
+    size_t code_size() const
+    {
+        return m_CodeSize;
+    }
+
+    bool match(const std::string &checkStr) const
+    {
+#ifdef LDEBUG
+        PROFILE_FUNCTION();
+#endif
+        if (m_Fn)
+        {
+            auto first = reinterpret_cast<const uint8_t *>(checkStr.data());
+            return m_Fn(first, first + checkStr.size()) != 0;
+        }
+        return m_Dfa.match(checkStr);
+    }
+
+  private:
+    using MatchFn_t = int (*)(const uint8_t *first, const uint8_t *last);
+
+#if YAREGEX_JIT
+    struct Emitter
+    {
+        void emit(std::initializer_list<uint8_t> bytes)
+        {
+            code.insert(code.end(), bytes);
+        }
+
+        void emit32(uint32_t value)
+        {
+            for (int idx{0}; idx < 4; ++idx)
+            {
+                code.push_back(static_cast<uint8_t>(value >> (8 * idx)));
+            }
+        }
+
+        // rel32 operand, resolved against labels once all blocks are placed
+        void emit_rel(size_t label)
+        {
+            relFixups.emplace_back(code.size(), label);
+            emit32(0);
+        }
+
+        // absolute 64 bit address, resolved when the executable memory is known
+        void emit_abs(size_t label)
+        {
+            absFixups.emplace_back(code.size(), label);
+            emit32(0);
+            emit32(0);
+        }
+
+        void bind(size_t label)
+        {
+            labels[label] = code.size();
+        }
+
+        std::vector<uint8_t> code;
+        std::vector<size_t> labels;
+        std::vector<std::pair<size_t, size_t>> relFixups, absFixups;
+    };
+
+    void compile()
+    {
+        const size_t stateCount = m_Dfa.size();
+        const size_t failLabel = stateCount;
+        auto label_of = [&](int32_t state) { return state == Dfa::Dead ? failLabel : static_cast<size_t>(state); };
+
+        Emitter em;
+        em.labels.resize(stateCount + 1);
+
+        // Entry: move the arguments to r8/r9, which are volatile in both calling conventions.
+#ifdef _WIN32
+        em.emit({0x49, 0x89, 0xC8}); // mov r8, rcx
+        em.emit({0x49, 0x89, 0xD1}); // mov r9, rdx
+#else
+        em.emit({0x49, 0x89, 0xF8}); // mov r8, rdi
+        em.emit({0x49, 0x89, 0xF1}); // mov r9, rsi
+#endif
+        em.emit({0xE9});
+        em.emit_rel(label_of(m_Dfa.start)); // jmp state_start
+
+        std::vector<std::pair<size_t, size_t>> jumpTables; // (state, label of table)
+        for (size_t state{0}; state < stateCount; ++state)
+        {
+            em.bind(state);
+            em.emit({0x4D, 0x39, 0xC8});      // cmp r8, r9
+            em.emit({0x72, 0x06});            // jb  +6
+            em.emit({0xB8});                  // mov eax, accept
+            em.emit32(m_Dfa.accept[state] ? 1 : 0);
+            em.emit({0xC3});                  // ret
+            em.emit({0x41, 0x0F, 0xB6, 0x00}); // movzx eax, byte [r8]
+            em.emit({0x49, 0xFF, 0xC0});      // inc r8
+
+            std::array<int32_t, 256> targets;
+            std::map<int32_t, size_t> frequency;
+            for (int byte{0}; byte < 256; ++byte)
+            {
+                targets[byte] = m_Dfa.next_state(static_cast<int32_t>(state), static_cast<uint8_t>(byte));
+                frequency[targets[byte]]++;
+            }
+            auto fallthrough = std::max_element(frequency.begin(), frequency.end(), [](auto &lhs, auto &rhs) {
+                                   return lhs.second < rhs.second;
+                               })->first;
+
+            // Byte ranges [lo, hi] that don't go to the fallthrough state.
+            std::vector<std::pair<int, int>> ranges;
+            for (int byte{0}; byte < 256; ++byte)
+            {
+                if (targets[byte] == fallthrough)
+                {
+                    continue;
+                }
+                if (!ranges.empty() && ranges.back().second == byte - 1 && targets[ranges.back().first] == targets[byte])
+                {
+                    ranges.back().second = byte;
+                    continue;
+                }
+                ranges.emplace_back(byte, byte);
+            }
+
+            if (ranges.size() > MaxCompares)
+            {
+                size_t tableLabel = em.labels.size();
+                em.labels.push_back(0);
+                jumpTables.emplace_back(state, tableLabel);
+                em.emit({0x48, 0x8D, 0x0D}); // lea rcx, [rip + table]
+                em.emit_rel(tableLabel);
+                em.emit({0xFF, 0x24, 0xC1}); // jmp qword [rcx + rax * 8]
+                continue;
+            }
+
+            for (auto &range : ranges)
+            {
+                auto target = label_of(targets[range.first]);
+                if (range.first == range.second)
+                {
+                    em.emit({0x3D}); // cmp eax, imm32
+                    em.emit32(static_cast<uint32_t>(range.first));
+                    em.emit({0x0F, 0x84}); // je target
+                    em.emit_rel(target);
+                    continue;
+                }
+                em.emit({0x8D, 0x88}); // lea ecx, [rax - lo]
+                em.emit32(static_cast<uint32_t>(-range.first));
+                em.emit({0x81, 0xF9}); // cmp ecx, hi - lo
+                em.emit32(static_cast<uint32_t>(range.second - range.first));
+                em.emit({0x0F, 0x86}); // jbe target
+                em.emit_rel(target);
+            }
+            em.emit({0xE9}); // jmp fallthrough
+            em.emit_rel(label_of(fallthrough));
+        }
+
+        em.bind(failLabel);
+        em.emit({0x31, 0xC0}); // xor eax, eax
+        em.emit({0xC3});       // ret
+
+        for (auto &jumpTable : jumpTables)
+        {
+            while (em.code.size() % 8)
+            {
+                em.emit({0xCC});
+            }
+            em.bind(jumpTable.second);
+            for (int byte{0}; byte < 256; ++byte)
+            {
+                em.emit_abs(label_of(
+                    m_Dfa.next_state(static_cast<int32_t>(jumpTable.first), static_cast<uint8_t>(byte))));
+            }
+        }
+
+        for (auto &fixup : em.relFixups)
+        {
+            auto rel = static_cast<int64_t>(em.labels[fixup.second]) - static_cast<int64_t>(fixup.first + 4);
+            auto rel32 = static_cast<uint32_t>(static_cast<int32_t>(rel));
+            std::memcpy(&em.code[fixup.first], &rel32, sizeof(rel32));
+        }
+
+        auto memory = static_cast<uint8_t *>(allocate(em.code.size()));
+        if (!memory)
+        {
+            return;
+        }
+        for (auto &fixup : em.absFixups)
+        {
+            uint64_t address = reinterpret_cast<uint64_t>(memory + em.labels[fixup.second]);
+            std::memcpy(&em.code[fixup.first], &address, sizeof(address));
+        }
+        std::memcpy(memory, em.code.data(), em.code.size());
+        m_Memory = memory;
+        m_CodeSize = em.code.size();
+        if (!protect())
+        {
+            release();
+            return;
+        }
+        m_Fn = reinterpret_cast<MatchFn_t>(memory);
+    }
+
+    // Memory is mapped writable first and flipped to executable once the code is in place (W^X).
+    static void *allocate(size_t size)
+    {
+#ifdef _WIN32
+        return VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+        void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return memory == MAP_FAILED ? nullptr : memory;
+#endif
+    }
+
+    bool protect()
+    {
+#ifdef _WIN32
+        DWORD oldProtect;
+        return VirtualProtect(m_Memory, m_CodeSize, PAGE_EXECUTE_READ, &oldProtect) != 0;
+#else
+        return mprotect(m_Memory, m_CodeSize, PROT_READ | PROT_EXEC) == 0;
+#endif
+    }
+#endif
+
+    void release()
+    {
+#if YAREGEX_JIT
+        if (m_Memory)
+        {
+#ifdef _WIN32
+            VirtualFree(m_Memory, 0, MEM_RELEASE);
+#else
+            munmap(m_Memory, m_CodeSize);
+#endif
+        }
+#endif
+        m_Memory = nullptr;
+        m_CodeSize = 0;
+        m_Fn = nullptr;
+    }
+
+  private:
+    Dfa m_Dfa;
+    void *m_Memory{nullptr};
+    size_t m_CodeSize{0};
+    MatchFn_t m_Fn{nullptr};
+};
+
+} // namespace lambda
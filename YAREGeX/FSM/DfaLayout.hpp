@@ -0,0 +1,222 @@
+#pragma once
+
+/**
+ * Profile-guided layout of the DFA transition table
+ * Subset construction numbers states in discovery order, so the rows a typical input keeps hitting end up
+ * scattered over the table. DfaProfile counts state visits over sample input and reorder_dfa renumbers the
+ * states hottest first, so the working set of the scan is the first few cache lines/pages of the table.
+ * The reordered table can be written out and loaded back, a load is only accepted for the same automaton.
+ *
+ * Author   : Bora Ilgar
+ * Version  : 0.9.1
+ */
+
+#include "../utility/yaregex_common.h"
+#include "Nfa2Dfa.hpp"
+#include <istream>
+#include <ostream>
+
+namespace lambda
+{
+
+// Visit counts of the states of one Dfa.
+struct DfaProfile
+{
+    // dfa has to outlive the profile.
+    explicit DfaProfile(const Dfa &dfa) : m_Dfa(dfa), m_Visits(dfa.size(), 0)
+    {
+    }
+
+    // A temporary would leave m_Dfa dangling.
+    explicit DfaProfile(Dfa &&) = delete;
+
+    // Runs sample like Dfa::match and counts every state it enters, the start state included.
+    void record(const std::string &sample)
+    {
+#ifdef LDEBUG
+        PROFILE_FUNCTION();
+#endif
+        int32_t state = m_Dfa.start;
+        for (auto ch : sample)
+        {
+            if (state == Dfa::Dead)
+            {
+                break;
+            }
+            ++m_Visits[state];
+            state = m_Dfa.next_state(state, static_cast<uint8_t>(ch));
+        }
+        if (state != Dfa::Dead)
+        {
+            ++m_Visits[state];
+        }
+    }
+
+    const std::vector<uint64_t> &visits() const
+    {
+        return m_Visits;
+    }
+
+    // States sorted hottest first, ties keep construction order: order[newId] = oldId.
+    std::vector<int32_t> hot_order() const
+    {
+        std::vector<int32_t> order(m_Visits.size());
+        for (size_t idx{0}; idx < order.size(); ++idx)
+        {
+            order[idx] = static_cast<int32_t>(idx);
+        }
+        std::stable_sort(order.begin(), order.end(),
+                         [this](int32_t lhs, int32_t rhs) { return m_Visits[lhs] > m_Visits[rhs]; });
+        return order;
+    }
+
+  private:
+    const Dfa &m_Dfa;
+    std::vector<uint64_t> m_Visits;
+};
+
+// Same automaton with state order[i] renumbered to i. order has to be a permutation of the states.
+inline Dfa renumber_dfa(const Dfa &dfa, const std::vector<int32_t> &order)
+{
+    assert(order.size() == dfa.size());
+    std::vector<int32_t> newId(dfa.size(), Dfa::Dead);
+    for (size_t idx{0}; idx < order.size(); ++idx)
+    {
+        newId[order[idx]] = static_cast<int32_t>(idx);
+    }
+
+    Dfa result;
+    result.byte_class = dfa.byte_class;
+    result.class_count = dfa.class_count;
+    result.start = dfa.start == Dfa::Dead ? Dfa::Dead : newId[dfa.start];
+    result.table.reserve(dfa.table.size());
+    result.accept.reserve(dfa.accept.size());
+    for (auto oldId : order)
+    {
+        for (uint32_t cls{0}; cls < dfa.class_count; ++cls)
+        {
+            auto next = dfa.table[oldId * dfa.class_count + cls];
+            result.table.push_back(next == Dfa::Dead ? Dfa::Dead : newId[next]);
+        }
+        result.accept.push_back(dfa.accept[oldId]);
+    }
+    return result;
+}
+
+inline Dfa reorder_dfa(const Dfa &dfa, const DfaProfile &profile)
+{
+#ifdef LDEBUG
+    PROFILE_FUNCTION();
+#endif
+    return renumber_dfa(dfa, profile.hot_order());
+}
+
+namespace detail
+{
+// True if lhs and rhs differ only in state numbering: both are walked from the start state in lockstep.
+inline bool same_automaton(const Dfa &lhs, const Dfa &rhs)
+{
+    if (lhs.size() != rhs.size() || lhs.class_count != rhs.class_count || lhs.byte_class != rhs.byte_class ||
+        (lhs.start == Dfa::Dead) != (rhs.start == Dfa::Dead))
+    {
+        return false;
+    }
+    if (lhs.start == Dfa::Dead)
+    {
+        return true;
+    }
+    std::vector<int32_t> pair(lhs.size(), Dfa::Dead);
+    std::vector<int32_t> work{lhs.start};
+    pair[lhs.start] = rhs.start;
+    while (!work.empty())
+    {
+        auto state = work.back();
+        work.pop_back();
+        if (lhs.accept[state] != rhs.accept[pair[state]])
+        {
+            return false;
+        }
+        for (uint32_t cls{0}; cls < lhs.class_count; ++cls)
+        {
+            auto next = lhs.table[state * lhs.class_count + cls];
+            auto other = rhs.table[pair[state] * rhs.class_count + cls];
+            if ((next == Dfa::Dead) != (other == Dfa::Dead))
+            {
+                return false;
+            }
+            if (next == Dfa::Dead)
+            {
+                continue;
+            }
+            if (pair[next] == Dfa::Dead)
+            {
+                pair[next] = other;
+                work.push_back(next);
+            }
+            else if (pair[next] != other)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <typename T> void write_pod(std::ostream &os, const T &value)
+{
+    os.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T> bool read_pod(std::istream &is, T &value)
+{
+    return static_cast<bool>(is.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+} // namespace detail
+
+// Binary image of dfa in host byte order: magic, class count, start, state count, byte classes, table, accept flags.
+inline void save_dfa(std::ostream &os, const Dfa &dfa)
+{
+    os.write("YRGXDFA1", 8);
+    detail::write_pod(os, dfa.class_count);
+    detail::write_pod(os, dfa.start);
+    detail::write_pod(os, static_cast<uint64_t>(dfa.size()));
+    os.write(reinterpret_cast<const char *>(dfa.byte_class.data()), dfa.byte_class.size());
+    os.write(reinterpret_cast<const char *>(dfa.table.data()),
+             static_cast<std::streamsize>(dfa.table.size() * sizeof(int32_t)));
+    os.write(reinterpret_cast<const char *>(dfa.accept.data()), static_cast<std::streamsize>(dfa.accept.size()));
+}
+
+// Reads an image written by save_dfa. Returns false and leaves dfa untouched if the image is truncated or
+// inconsistent (bad magic, a state or class id out of range).
+inline bool load_dfa(std::istream &is, Dfa &dfa)
+{
+    char magic[8];
+    Dfa loaded;
+    uint64_t states{0};
+    if (!is.read(magic, 8) || std::memcmp(magic, "YRGXDFA1", 8) != 0 || !detail::read_pod(is, loaded.class_count) ||
+        !detail::read_pod(is, loaded.start) || !detail::read_pod(is, states) || loaded.class_count == 0 ||
+        loaded.class_count > 256 || states > (uint64_t{1} << 31) / loaded.class_count)
+    {
+        return false;
+    }
+    loaded.table.resize(states * loaded.class_count);
+    loaded.accept.resize(states);
+    if (!is.read(reinterpret_cast<char *>(loaded.byte_class.data()), loaded.byte_class.size()) ||
+        !is.read(reinterpret_cast<char *>(loaded.table.data()),
+                 static_cast<std::streamsize>(loaded.table.size() * sizeof(int32_t))) ||
+        !is.read(reinterpret_cast<char *>(loaded.accept.data()), static_cast<std::streamsize>(loaded.accept.size())))
+    {
+        return false;
+    }
+    auto valid = [&](int32_t state) { return state == Dfa::Dead || (state >= 0 && uint64_t(state) < states); };
+    bool ok = valid(loaded.start) && std::all_of(loaded.table.begin(), loaded.table.end(), valid) &&
+              std::all_of(loaded.byte_class.begin(), loaded.byte_class.end(),
+                          [&](uint8_t cls) { return cls < loaded.class_count; });
+    if (ok)
+    {
+        dfa = std::move(loaded);
+    }
+    return ok;
+}
+
+} // namespace lambda
@@ -0,0 +1,173 @@
+#pragma once
+
+/**
+ * Incremental DFA matching of an edited buffer
+ * A full scan records the DFA state every few KiB of input. After an edit the buffer is scanned again from the
+ * last checkpoint before the edit, and the scan stops as soon as it is in the same state the previous run was
+ * in at the same (shifted) position behind the edit: from there on both runs read the same bytes, so the old
+ * result still holds. A small edit costs a few checkpoint intervals instead of the whole document.
+ *
+ * Author   : Bora Ilgar
+ * Version  : 0.9.1
+ */
+
+#include "../utility/yaregex_common.h"
+#include "Nfa2Dfa.hpp"
+
+// Checkpoints are (offset, state) pairs, state being the DFA state before the byte at offset. They start out
+// every Interval bytes; edits shift the ones behind the edit, so the spacing drifts but never exceeds Interval.
+//
+//     old : |--cp--------cp--[ removed ]--cp--------cp----|
+//     new : |--cp--------cp--[ inserted    ]----cp--------cp----|
+//                        ^ resume                ^ re-converged, the rest is reused as is
+
+namespace lambda
+{
+
+struct IncrementalMatch
+{
+    static constexpr size_t DefaultInterval = 4096;
+
+    // The matcher keeps its own copy of dfa, move it in to avoid the copy.
+    IncrementalMatch(Dfa dfa, size_t interval = DefaultInterval)
+        : m_Dfa(std::move(dfa)), m_Interval(std::max<size_t>(interval, 1))
+    {
+        assert(!m_Dfa.empty());
+    }
+
+    // Scans the whole buffer and records its checkpoints.
+    // Same semantics as RgxMatch::match: the whole string has to be accepted.
+    bool match(const std::string &checkStr)
+    {
+#ifdef LDEBUG
+        PROFILE_FUNCTION();
+#endif
+        m_Checkpoints.assign(1, {0, m_Dfa.start});
+        m_Length = checkStr.size();
+        m_Final = scan(checkStr, {}, 0);
+        return m_Dfa.is_accept(m_Final);
+    }
+
+    // Re-matches checkStr after [pos, pos + removed) of the previously matched buffer has been replaced by
+    // [pos, pos + inserted) of checkStr. An edit that does not fit the previous buffer is scanned from scratch.
+    bool rematch(const std::string &checkStr, size_t pos, size_t removed, size_t inserted)
+    {
+#ifdef LDEBUG
+        PROFILE_FUNCTION();
+#endif
+        if (m_Checkpoints.empty() || pos + removed > m_Length || m_Length - removed + inserted != checkStr.size())
+        {
+            return match(checkStr);
+        }
+
+        // Checkpoints behind the edit, moved to the offsets of the new buffer.
+        std::vector<Checkpoint> tail;
+        auto firstBehind = std::lower_bound(m_Checkpoints.begin(), m_Checkpoints.end(), pos + removed,
+                                            [](const Checkpoint &cp, size_t offset) { return cp.offset < offset; });
+        for (auto it = firstBehind; it != m_Checkpoints.end(); ++it)
+        {
+            tail.push_back({it->offset - removed + inserted, it->state});
+        }
+
+        // Everything up to and including the last checkpoint not after pos is still valid.
+        auto resume = std::upper_bound(m_Checkpoints.begin(), m_Checkpoints.end(), pos,
+                                       [](size_t offset, const Checkpoint &cp) { return offset < cp.offset; });
+        m_Checkpoints.erase(resume, m_Checkpoints.end());
+        m_Length = checkStr.size();
+        auto state = scan(checkStr, std::move(tail), pos + inserted);
+        if (state != Unchanged)
+        {
+            m_Final = state;
+        }
+        return m_Dfa.is_accept(m_Final);
+    }
+
+    // Bytes read by the last match or rematch.
+    size_t rescanned() const
+    {
+        return m_Rescanned;
+    }
+
+    // True if the last rematch stopped early on a checkpoint of the previous run.
+    bool converged() const
+    {
+        return m_Converged;
+    }
+
+    size_t checkpoint_count() const
+    {
+        return m_Checkpoints.size();
+    }
+
+  private:
+    struct Checkpoint
+    {
+        size_t offset;
+        int32_t state;
+    };
+
+    // scan result when the run re-converged, the final state of the previous run still holds
+    static constexpr int32_t Unchanged = -2;
+
+    // Runs from the last checkpoint to the end of checkStr, appending checkpoints on the way. The run may stop on
+    // a checkpoint of tail at or after editEnd if it is in the same state there. Returns the final state.
+    int32_t scan(const std::string &checkStr, std::vector<Checkpoint> &&tail, size_t editEnd)
+    {
+        const char *data = checkStr.data();
+        size_t offset = m_Checkpoints.back().offset;
+        int32_t state = m_Checkpoints.back().state;
+        size_t begin = offset;
+        auto next = tail.begin();
+        m_Converged = false;
+
+        while (offset < checkStr.size() && state != Dfa::Dead)
+        {
+            while (next != tail.end() && next->offset < std::max(offset, editEnd))
+            {
+                ++next;
+            }
+            if (next != tail.end() && next->offset == offset)
+            {
+                if (next->state == state)
+                {
+                    m_Converged = true;
+                    if (m_Checkpoints.back().offset == offset)
+                    {
+                        ++next;
+                    }
+                    m_Checkpoints.insert(m_Checkpoints.end(), next, tail.end());
+                    m_Rescanned = offset - begin;
+                    return Unchanged;
+                }
+                ++next;
+            }
+            if (offset - m_Checkpoints.back().offset >= m_Interval)
+            {
+                m_Checkpoints.push_back({offset, state});
+            }
+
+            // Run to whichever comes first: the next checkpoint to record, the next one to compare with, the end.
+            size_t stop = std::min(checkStr.size(), m_Checkpoints.back().offset + m_Interval);
+            if (next != tail.end())
+            {
+                stop = std::min(stop, next->offset);
+            }
+            stop = std::max(stop, offset + 1);
+            state = m_Dfa.run(state, data + offset, data + stop);
+            offset = stop;
+        }
+        m_Rescanned = offset - begin;
+        return state;
+    }
+
+  private:
+    Dfa m_Dfa;
+    size_t m_Interval;
+    std::vector<Checkpoint> m_Checkpoints;
+    size_t m_Length{0};
+    int32_t m_Final{Dfa::Dead};
+    size_t m_Rescanned{0};
+    bool m_Converged{false};
+};
+
+} // namespace lambda
@@ -0,0 +1,230 @@
+#pragma once
+
+/**
+ * Memory-bounded DFA state cache
+ * Builds DFA states on demand while matching instead of running the whole subset construction up front,
+ * so only the configurations the input actually reaches are ever created. The cache has a hard byte budget:
+ * when it is full it is cleared and rebuilt, and when clearing stops paying off matching falls back to
+ * RgxMatch for good.
+ * For detail see: https://swtch.com/~rsc/regexp/regexp1.html (Caching the NFA to build a DFA)
+ *
+ * Author   : Bora Ilgar
+ * Version  : 0.9.1
+ */
+
+#include "../utility/yaregex_common.h"
+#include "Nfa2Dfa.hpp"
+#include "NfaMatcher.hpp"
+
+namespace lambda
+{
+
+struct LazyDfa
+{
+    static constexpr int32_t Unknown = -2; // transition not computed yet
+    static constexpr size_t DefaultBudget = 1 << 20;
+    static constexpr size_t DefaultMaxClears = 8;
+    // A clear is "too often" when the cache was not able to process this many bytes per cached state.
+    static constexpr size_t MinBytesPerState = 10;
+
+    LazyDfa(const StatePtr_t &start, size_t memoryBudget = DefaultBudget, size_t maxClears = DefaultMaxClears)
+        : m_Start(start), m_NfaMatch(m_Start), m_Budget(memoryBudget), m_MaxClears(maxClears)
+    {
+        detail::compute_byte_classes(detail::collect_states(m_Start), m_Dfa);
+    }
+
+    // Same semantics as RgxMatch::match: the whole string has to be accepted.
+    bool match(const std::string &checkStr)
+    {
+#ifdef LDEBUG
+        PROFILE_FUNCTION();
+#endif
+        if (m_GaveUp)
+        {
+            return m_NfaMatch.match(checkStr);
+        }
+
+        int32_t state = start_state();
+        if (state == Unknown)
+        {
+            m_GaveUp = true;
+            return m_NfaMatch.match(checkStr);
+        }
+        for (auto ch : checkStr)
+        {
+            auto byte = static_cast<uint8_t>(ch);
+            int32_t next = m_Dfa.table[state * m_Dfa.class_count + m_Dfa.byte_class[byte]];
+            if (next == Unknown)
+            {
+                next = compute(state, byte);
+                if (m_GaveUp)
+                {
+                    return m_NfaMatch.match(checkStr);
+                }
+            }
+            if (next == Dfa::Dead)
+            {
+                return false;
+            }
+            state = next;
+            ++m_BytesSinceClear;
+        }
+        return m_Dfa.is_accept(state);
+    }
+
+    // Bytes currently held by the cache (transition rows, accept flags and the state keys), reserved capacity
+    // included.
+    size_t memory_usage() const
+    {
+        return m_Memory + m_Dfa.table.capacity() * sizeof(int32_t) + m_Dfa.accept.capacity() * sizeof(uint8_t) +
+               m_Keys.capacity() * sizeof(DStateKey_t);
+    }
+
+    size_t budget() const
+    {
+        return m_Budget;
+    }
+
+    size_t state_count() const
+    {
+        return m_Keys.size();
+    }
+
+    size_t clear_count() const
+    {
+        return m_Clears;
+    }
+
+    // True once the cache has been abandoned in favor of RgxMatch.
+    bool gave_up() const
+    {
+        return m_GaveUp;
+    }
+
+  private:
+    // Rough cost of one cached state besides its row: its key (in m_Keys and copied as the map key) and a map node.
+    static size_t key_cost(const DStateKey_t &key)
+    {
+        return (key.capacity() + key.size()) * sizeof(State *) + sizeof(DStateKey_t) + 4 * sizeof(void *);
+    }
+
+    // Bytes of table, accept and m_Keys with room for states states.
+    size_t row_bytes(size_t states) const
+    {
+        return states * (m_Dfa.class_count * sizeof(int32_t) + sizeof(uint8_t) + sizeof(DStateKey_t));
+    }
+
+    int32_t start_state()
+    {
+        if (m_StartId == Unknown)
+        {
+            m_StartId = add_state(detail::closure({m_Start.get()}));
+        }
+        return m_StartId;
+    }
+
+    // Returns the id of key, Dead for the empty configuration, Unknown if the budget is exhausted.
+    int32_t add_state(DStateKey_t &&key)
+    {
+        if (key.empty())
+        {
+            return Dfa::Dead;
+        }
+        auto it = m_Ids.find(key);
+        if (it != m_Ids.end())
+        {
+            return it->second;
+        }
+        // The vectors grow by reserve only, so their capacity is exactly what the budget was charged for:
+        // doubled while that fits, otherwise one state at a time.
+        auto cost = key_cost(key);
+        auto states = m_Keys.size() + 1;
+        auto capacity = m_Keys.capacity();
+        if (states > capacity)
+        {
+            capacity = std::max<size_t>(2 * capacity, 4);
+            if (m_Memory + cost + row_bytes(capacity) > m_Budget)
+            {
+                capacity = states;
+            }
+        }
+        if (m_Memory + cost + row_bytes(capacity) > m_Budget)
+        {
+            return Unknown;
+        }
+        m_Keys.reserve(capacity);
+        m_Dfa.table.reserve(capacity * m_Dfa.class_count);
+        m_Dfa.accept.reserve(capacity);
+
+        auto id = static_cast<int32_t>(m_Keys.size());
+        m_Dfa.accept.push_back(detail::is_accepting(key));
+        m_Dfa.table.resize(m_Dfa.table.size() + m_Dfa.class_count, Unknown);
+        m_Ids.emplace(key, id);
+        m_Keys.push_back(std::move(key));
+        m_Memory += cost;
+        return id;
+    }
+
+    // Fills the transition of state on byte. When the budget is exhausted the cache is cleared and
+    // both ends of the transition are re-added, state ids change so the caller has to re-read the table.
+    int32_t compute(int32_t &state, uint8_t byte)
+    {
+        auto nextKey = detail::transition(m_Keys[state], byte);
+        auto next = add_state(DStateKey_t(nextKey));
+        if (next == Unknown)
+        {
+            auto currentKey = m_Keys[state];
+            if (!clear())
+            {
+                return Dfa::Dead;
+            }
+            state = add_state(std::move(currentKey));
+            next = add_state(std::move(nextKey));
+            if (state == Unknown || next == Unknown)
+            {
+                // The budget can not even hold two states.
+                m_GaveUp = true;
+                return Dfa::Dead;
+            }
+        }
+        m_Dfa.table[state * m_Dfa.class_count + m_Dfa.byte_class[byte]] = next;
+        return next;
+    }
+
+    // Drops every cached state. Returns false (and gives up) if clears stopped paying off.
+    bool clear()
+    {
+        if (m_BytesSinceClear < MinBytesPerState * m_Keys.size())
+        {
+            ++m_Strikes;
+        }
+        if (m_Strikes > m_MaxClears)
+        {
+            m_GaveUp = true;
+        }
+        ++m_Clears;
+        m_BytesSinceClear = 0;
+        // swap, not clear(): the capacity has to be released too
+        std::vector<DStateKey_t>().swap(m_Keys);
+        std::vector<int32_t>().swap(m_Dfa.table);
+        std::vector<uint8_t>().swap(m_Dfa.accept);
+        m_Ids.clear();
+        m_Memory = 0;
+        m_StartId = Unknown;
+        return !m_GaveUp;
+    }
+
+  private:
+    StatePtr_t m_Start;
+    RgxMatch m_NfaMatch;
+    Dfa m_Dfa; // byte classes, table and accept flags of the cached states
+    std::vector<DStateKey_t> m_Keys;
+    std::map<DStateKey_t, int32_t> m_Ids;
+    int32_t m_StartId{Unknown};
+    size_t m_Budget, m_MaxClears;
+    size_t m_Memory{0}; // keys and map nodes, the vectors are counted by their capacity
+    size_t m_Clears{0}, m_Strikes{0}, m_BytesSinceClear{0};
+    bool m_GaveUp{false};
+};
+
+} // namespace lambda
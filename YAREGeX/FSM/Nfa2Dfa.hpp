@@ -28,16 +28,196 @@
 
 namespace lambda
 {
-using StatePtrVec_t = std::vector<StatePtr_t>;
-using T = std::pair<StatePtrVec_t, int8_t>;
-struct DState
+using DStateKey_t = std::vector<State *>;
+
+// Result of the subset construction.
+// Bytes that no NFA state can tell apart share one byte class, so a row of the transition table
+// holds class_count entries instead of 256.
+struct Dfa
 {
-    DState(StatePtrVec_t &l)
+    static constexpr int32_t Dead = -1;
+
+    // Number of DFA states; zero when the construction gave up (see make_dfa).
+    size_t size() const
+    {
+        return accept.size();
+    }
+
+    bool empty() const
+    {
+        return accept.empty();
+    }
+
+    int32_t next_state(int32_t state, uint8_t byte) const
+    {
+        return table[state * class_count + byte_class[byte]];
+    }
+
+    bool is_accept(int32_t state) const
     {
+        return state != Dead && accept[state];
     }
 
-  private:
-    std::map<T, StatePtrVec_t> m_Next;
+    // Runs the automaton over [first, last) starting from state.
+    // Returns Dead as soon as no continuation can match.
+    int32_t run(int32_t state, const char *first, const char *last) const
+    {
+        for (; first != last && state != Dead; ++first)
+        {
+            state = next_state(state, static_cast<uint8_t>(*first));
+        }
+        return state;
+    }
+
+    // Same semantics as RgxMatch::match: the whole string has to be accepted.
+    bool match(const std::string &checkStr) const
+    {
+#ifdef LDEBUG
+        PROFILE_FUNCTION();
+#endif
+        return is_accept(run(start, checkStr.data(), checkStr.data() + checkStr.size()));
+    }
+
+    // Bytes held by the transition table, not counting the object itself.
+    size_t memory_usage() const
+    {
+        return table.capacity() * sizeof(int32_t) + accept.capacity() * sizeof(uint8_t);
+    }
+
+    std::array<uint8_t, 256> byte_class{};
+    uint32_t class_count{0};
+    int32_t start{Dead};
+    std::vector<int32_t> table;  // table[state * class_count + class] -> state or Dead
+    std::vector<uint8_t> accept; // accept[state] != 0 if the configuration contains the match-state
 };
 
+namespace detail
+{
+// Partitions the byte alphabet: two bytes land in the same class when exactly the same char states accept them.
+inline void compute_byte_classes(const StatePtrVec_t &states, Dfa &dfa)
+{
+    std::map<std::vector<State *>, uint8_t> classes;
+    for (int byte{0}; byte < 256; ++byte)
+    {
+        std::vector<State *> acceptedBy;
+        for (auto &state : states)
+        {
+            if (accepts(state.get(), static_cast<uint8_t>(byte)))
+            {
+                acceptedBy.push_back(state.get());
+            }
+        }
+        auto it = classes.find(acceptedBy);
+        if (it == classes.end())
+        {
+            it = classes.emplace(acceptedBy, static_cast<uint8_t>(classes.size())).first;
+        }
+        dfa.byte_class[byte] = it->second;
+    }
+    dfa.class_count = static_cast<uint32_t>(classes.size());
+}
+
+// One representative byte per class is enough to compute the transitions of the whole class.
+inline std::vector<uint8_t> class_representatives(const Dfa &dfa)
+{
+    std::vector<uint8_t> representative(dfa.class_count);
+    for (int byte{255}; byte >= 0; --byte)
+    {
+        representative[dfa.byte_class[byte]] = static_cast<uint8_t>(byte);
+    }
+    return representative;
+}
+
+// Move(q, c) followed by e-closure: the configuration reached from key after reading byte.
+inline DStateKey_t transition(const DStateKey_t &key, uint8_t byte)
+{
+    DStateKey_t moved;
+    for (auto state : key)
+    {
+        if (accepts(state, byte))
+        {
+            moved.push_back(state->next0.get());
+        }
+    }
+    return closure(moved);
+}
+
+inline bool is_accepting(const DStateKey_t &key)
+{
+    return std::any_of(key.begin(), key.end(),
+                       [](State *state) { return state->ch == static_cast<int>(State::Type::Match); });
+}
+} // namespace detail
+
+// Builds a DFA from the NFA created by make_nfa.
+// Subset construction is exponential in the worst case, when more than maxStates DFA states are needed
+// the construction is abandoned and an empty Dfa is returned, callers are expected to keep using RgxMatch then.
+// maxBytes bounds the memory of the construction the same way: the table (by capacity), the accept flags and
+// the configuration keys, which are held twice while the construction runs.
+inline Dfa make_dfa(const StatePtr_t &start, size_t maxStates = 1 << 16, size_t maxBytes = static_cast<size_t>(-1))
+{
+#ifdef LDEBUG
+    PROFILE_FUNCTION();
+#endif
+    Dfa dfa;
+    auto states = detail::collect_states(start);
+    detail::compute_byte_classes(states, dfa);
+
+    auto representative = detail::class_representatives(dfa);
+
+    std::map<DStateKey_t, int32_t> dstates;
+    std::vector<DStateKey_t> worklist;
+    bool overflow{false};
+    size_t keyBytes{0};
+    const size_t rowBytes = dfa.class_count * sizeof(int32_t) + sizeof(uint8_t);
+    auto add_dstate = [&](DStateKey_t &&key) -> int32_t {
+        if (key.empty())
+        {
+            return Dfa::Dead;
+        }
+        auto it = dstates.find(key);
+        if (it != dstates.end())
+        {
+            return it->second;
+        }
+        // checked per new state: a single row may discover up to class_count of them
+        auto cost = 2 * (key.size() * sizeof(State *) + sizeof(DStateKey_t)) + 4 * sizeof(void *);
+        auto capacity = dfa.accept.capacity();
+        if (dstates.size() == capacity)
+        {
+            // doubled while that fits, the table only ever grows by reserve so its capacity is what was checked
+            capacity = std::min(std::max<size_t>(2 * capacity, 16), maxStates);
+            if (keyBytes + cost + capacity * rowBytes > maxBytes)
+            {
+                capacity = dstates.size() + 1;
+            }
+        }
+        if (dstates.size() >= maxStates || keyBytes + cost + capacity * rowBytes > maxBytes)
+        {
+            overflow = true;
+            return Dfa::Dead;
+        }
+        dfa.accept.reserve(capacity);
+        dfa.table.reserve(capacity * dfa.class_count);
+        keyBytes += cost;
+        auto id = static_cast<int32_t>(dstates.size());
+        dfa.accept.push_back(detail::is_accepting(key));
+        dfa.table.resize(dfa.table.size() + dfa.class_count, Dfa::Dead);
+        dstates.emplace(key, id);
+        worklist.push_back(std::move(key));
+        return id;
+    };
+
+    dfa.start = add_dstate(detail::closure({start.get()}));
+    for (size_t idx{0}; idx < worklist.size() && !overflow; ++idx)
+    {
+        for (uint32_t cls{0}; cls < dfa.class_count && !overflow; ++cls)
+        {
+            auto target = add_dstate(detail::transition(worklist[idx], representative[cls]));
+            dfa.table[idx * dfa.class_count + cls] = target;
+        }
+    }
+    return overflow ? Dfa{} : dfa;
+}
+
 } // namespace lambda
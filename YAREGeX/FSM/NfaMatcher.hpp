@@ -13,6 +13,7 @@
 
 #include "../utility/yaregex_common.h"
 #include "Rgx2Nfa.hpp"
+#include <atomic>
 
 namespace lambda
 {
@@ -91,7 +92,8 @@ struct RgxMatch
     // initial_state creates an initial state list by adding just a start state
     auto init(StatePtr_t &state, std::vector<StatePtr_t> &currHolder) -> decltype(currHolder)
     {
-        m_ListID++;
+        m_ListID = next_list_id();
+        currHolder.clear();
         add_state(currHolder, state);
         return currHolder;
     }
@@ -104,22 +106,33 @@ struct RgxMatch
         PROFILE_FUNCTION();
 #endif
         std::shared_ptr<State> state;
-        m_ListID++;
+        m_ListID = next_list_id();
+        nextHolder.clear();
 
         for (auto &curr_state : currentHolder)
         {
             state = curr_state;
-            if (state->ch == ch)
+            if (detail::accepts(state.get(), static_cast<uint8_t>(ch)))
             {
                 add_state(nextHolder, state->next0);
             }
         }
     }
 
+    // States are shared by every matcher created on the same NFA, so the generation number
+    // has to be unique process-wide; a per-matcher counter would collide with stale last_list values.
+    // Atomic so that matchers of different NFAs can run on different threads.
+    // 64 bit: every input byte of every scan takes one, 2^32 of them are only a few GB of input.
+    static uint64_t next_list_id()
+    {
+        static std::atomic<uint64_t> sListID{0};
+        return ++sListID;
+    }
+
   private:
     // NFA has been built, we need to simulate it.
     // The simulation requires tracking State sets, which are stored as a simple vector:
-    uint32_t m_ListID{0};
+    uint64_t m_ListID{0};
     std::vector<StatePtr_t> curr, next;
     friend class DState;
     StatePtr_t m_Start;
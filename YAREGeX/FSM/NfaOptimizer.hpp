@@ -0,0 +1,547 @@
+#pragma once
+
+/**
+ * Optimization passes over the NFA created by make_nfa
+ * Thompson's construction emits one Split state per operator, so the raw program contains epsilon chains,
+ * nested loops like (a*)* and duplicated alternation prefixes/suffixes. Every Split state reached is
+ * another call of add_state per input byte, these passes shrink the program before it is simulated.
+ *
+ * Author   : Bora Ilgar
+ * Version  : 0.9.1
+ */
+
+#include "../utility/yaregex_common.h"
+#include "Rgx2Nfa.hpp"
+
+namespace lambda
+{
+
+struct NfaOptStats
+{
+    size_t states_before{0}, states_after{0};
+    size_t splits_before{0}, splits_after{0};
+};
+
+// Runs the passes below until the program stops shrinking:
+//  collapse_epsilon  : Split states with a single distinct exit and epsilon cycles ((a*)*, (a?)*) are bypassed
+//  eliminate_dead    : arrows to states that can not reach the match-state are cut
+//  factor_prefixes   : ab|ac  -> a(b|c)
+//  merge_equivalent  : states with the same label and the same successors are merged, this also factors
+//                      common suffixes since every alternative is patched to the same out state (ab|cb -> (a|c)b)
+// The start state keeps its identity unless it is bypassed, so pass the same pointer used for make_nfa.
+struct NfaOptimizer
+{
+    NfaOptimizer(StatePtr_t &start) : m_Start(start)
+    {
+    }
+
+    NfaOptStats run(size_t maxRounds = 8)
+    {
+#ifdef LDEBUG
+        PROFILE_FUNCTION();
+#endif
+        NfaOptStats stats;
+        count(stats.states_before, stats.splits_before);
+        for (size_t round{0}; round < maxRounds; ++round)
+        {
+            bool changed = collapse_epsilon();
+            changed |= eliminate_dead();
+            changed |= factor_prefixes();
+            changed |= merge_equivalent();
+            if (!changed)
+            {
+                break;
+            }
+        }
+        count(stats.states_after, stats.splits_after);
+        return stats;
+    }
+
+  private:
+    using Redirect_t = std::map<State *, StatePtr_t>;
+
+    static bool is_split(const StatePtr_t &state)
+    {
+        return state && state->ch == static_cast<int>(State::Type::Split);
+    }
+
+    void count(size_t &states, size_t &splits) const
+    {
+        auto all = detail::collect_states(m_Start);
+        states = all.size();
+        splits = static_cast<size_t>(std::count_if(all.begin(), all.end(), is_split));
+    }
+
+    static StatePtr_t resolve(const Redirect_t &redirect, StatePtr_t state)
+    {
+        for (auto it = redirect.find(state.get()); state && it != redirect.end(); it = redirect.find(state.get()))
+        {
+            state = it->second;
+        }
+        return state;
+    }
+
+    // Rewrites every arrow (and the start pointer) according to redirect.
+    void apply(const Redirect_t &redirect)
+    {
+        for (auto &state : detail::collect_states(m_Start))
+        {
+            state->next0 = resolve(redirect, state->next0);
+            state->next1 = resolve(redirect, state->next1);
+        }
+        auto start = resolve(redirect, m_Start);
+        if (start)
+        {
+            m_Start = start;
+        }
+    }
+
+    // Builds Split(alts[0], Split(alts[1], ...)), a single alternative needs no Split at all.
+    static StatePtr_t make_chain(const StatePtrVec_t &alts, size_t first = 0)
+    {
+        if (first + 1 == alts.size())
+        {
+            return alts[first];
+        }
+        return make_state<State>(State::Type::Split, alts[first], make_chain(alts, first + 1));
+    }
+
+    // Strongly connected components of the graph of Split states and their Split-to-Split arrows (Tarjan,
+    // iterative). Members of a component are listed in the order of states, so are the components.
+    static std::vector<StatePtrVec_t> split_components(const StatePtrVec_t &states)
+    {
+        std::map<State *, size_t> position;
+        for (size_t idx{0}; idx < states.size(); ++idx)
+        {
+            position[states[idx].get()] = idx;
+        }
+        const size_t unvisited = states.size();
+        std::vector<size_t> index(states.size(), unvisited), low(states.size(), 0);
+        std::vector<bool> onStack(states.size(), false);
+        std::vector<size_t> stack;
+        std::vector<std::vector<size_t>> components;
+        size_t counter{0};
+
+        struct Frame
+        {
+            size_t state;
+            int arrow; // next arrow to follow: 0 -> next0, 1 -> next1
+        };
+        auto visit = [&](size_t state, std::vector<Frame> &frames) {
+            index[state] = low[state] = counter++;
+            stack.push_back(state);
+            onStack[state] = true;
+            frames.push_back({state, 0});
+        };
+
+        for (size_t root{0}; root < states.size(); ++root)
+        {
+            if (!is_split(states[root]) || index[root] != unvisited)
+            {
+                continue;
+            }
+            std::vector<Frame> frames;
+            visit(root, frames);
+            while (!frames.empty())
+            {
+                auto &frame = frames.back();
+                if (frame.arrow < 2)
+                {
+                    auto &next = frame.arrow++ == 0 ? states[frame.state]->next0 : states[frame.state]->next1;
+                    if (!is_split(next))
+                    {
+                        continue;
+                    }
+                    auto target = position[next.get()];
+                    if (index[target] == unvisited)
+                    {
+                        visit(target, frames);
+                    }
+                    else if (onStack[target])
+                    {
+                        low[frame.state] = std::min(low[frame.state], index[target]);
+                    }
+                    continue;
+                }
+                auto state = frame.state;
+                frames.pop_back();
+                if (!frames.empty())
+                {
+                    low[frames.back().state] = std::min(low[frames.back().state], low[state]);
+                }
+                if (low[state] != index[state])
+                {
+                    continue;
+                }
+                std::vector<size_t> component;
+                size_t member;
+                do
+                {
+                    member = stack.back();
+                    stack.pop_back();
+                    onStack[member] = false;
+                    component.push_back(member);
+                } while (member != state);
+                std::sort(component.begin(), component.end());
+                components.push_back(std::move(component));
+            }
+        }
+
+        std::sort(components.begin(), components.end(),
+                  [](const std::vector<size_t> &lhs, const std::vector<size_t> &rhs) { return lhs.front() < rhs.front(); });
+        std::vector<StatePtrVec_t> result;
+        for (auto &component : components)
+        {
+            StatePtrVec_t members;
+            for (auto idx : component)
+            {
+                members.push_back(states[idx]);
+            }
+            result.push_back(std::move(members));
+        }
+        return result;
+    }
+
+    // Every strongly connected group of Split states has the same closure, it is replaced by one chain over its
+    // distinct exits. A lone Split with a single distinct exit (x|x, or a nulled branch) is bypassed.
+    bool collapse_epsilon()
+    {
+        Redirect_t redirect;
+        for (auto &members : split_components(detail::collect_states(m_Start)))
+        {
+            std::map<State *, bool> inside, seen;
+            for (auto &member : members)
+            {
+                inside[member.get()] = true;
+            }
+            StatePtrVec_t exits;
+            for (auto &member : members)
+            {
+                for (auto &next : {member->next0, member->next1})
+                {
+                    if (next && !inside[next.get()] && !seen[next.get()])
+                    {
+                        seen[next.get()] = true;
+                        exits.push_back(next);
+                    }
+                }
+            }
+            if (members.size() == 1 && exits.size() == 2)
+            {
+                continue;
+            }
+            if (exits.size() < 2)
+            {
+                for (auto &member : members)
+                {
+                    redirect[member.get()] = exits.empty() ? nullptr : exits.front();
+                }
+                continue;
+            }
+            auto &root = members.front();
+            root->next0 = exits.front();
+            root->next1 = make_chain(exits, 1);
+            for (size_t idx{1}; idx < members.size(); ++idx)
+            {
+                redirect[members[idx].get()] = root;
+            }
+        }
+        apply(redirect);
+        return !redirect.empty();
+    }
+
+    // Cuts arrows to states from which the match-state is unreachable.
+    bool eliminate_dead()
+    {
+        auto states = detail::collect_states(m_Start);
+        std::map<State *, std::vector<State *>> predecessors;
+        std::vector<State *> work;
+        std::map<State *, bool> live;
+        for (auto &state : states)
+        {
+            for (auto next : {state->next0.get(), state->next1.get()})
+            {
+                if (next)
+                {
+                    predecessors[next].push_back(state.get());
+                }
+            }
+            if (state->ch == static_cast<int>(State::Type::Match))
+            {
+                live[state.get()] = true;
+                work.push_back(state.get());
+            }
+        }
+        while (!work.empty())
+        {
+            auto state = work.back();
+            work.pop_back();
+            for (auto pred : predecessors[state])
+            {
+                if (!live[pred])
+                {
+                    live[pred] = true;
+                    work.push_back(pred);
+                }
+            }
+        }
+
+        bool changed{false};
+        for (auto &state : states)
+        {
+            for (auto next : {&state->next0, &state->next1})
+            {
+                if (*next && !live[next->get()])
+                {
+                    next->reset();
+                    changed = true;
+                }
+            }
+        }
+        return changed;
+    }
+
+    // Epsilon frontier of a Split state: the non-Split states of its closure. The Split states walked through,
+    // split itself first, go to inner.
+    static StatePtrVec_t frontier(const StatePtr_t &split, StatePtrVec_t &inner)
+    {
+        StatePtrVec_t result, work{split};
+        std::map<State *, bool> seen;
+        while (!work.empty())
+        {
+            auto state = work.back();
+            work.pop_back();
+            if (!state || seen[state.get()])
+            {
+                continue;
+            }
+            seen[state.get()] = true;
+            if (is_split(state))
+            {
+                inner.push_back(state);
+                work.push_back(state->next1);
+                work.push_back(state->next0);
+                continue;
+            }
+            result.push_back(state);
+        }
+        return result;
+    }
+
+    // States a rewrite of inner.front() leaves unreachable: the other inner Splits and the grouped alternatives,
+    // unless inDegree shows an arrow into them from outside (a loop mostly). Tails stay, the factored states
+    // point to them.
+    static size_t released_states(const StatePtrVec_t &inner, const StatePtrVec_t &grouped, const StatePtrVec_t &tails,
+                                  std::map<State *, size_t> &inDegree)
+    {
+        std::map<State *, size_t> innerArrows;
+        std::map<State *, bool> candidate, kept;
+        for (auto &state : inner)
+        {
+            for (auto next : {state->next0.get(), state->next1.get()})
+            {
+                ++innerArrows[next];
+            }
+        }
+        for (auto &state : grouped)
+        {
+            ++innerArrows[state->next0.get()];
+        }
+        for (size_t idx{1}; idx < inner.size(); ++idx)
+        {
+            candidate[inner[idx].get()] = true;
+        }
+        for (auto &state : grouped)
+        {
+            candidate[state.get()] = true;
+        }
+
+        std::vector<State *> work;
+        for (auto &entry : candidate)
+        {
+            if (inDegree[entry.first] > innerArrows[entry.first])
+            {
+                work.push_back(entry.first);
+            }
+        }
+        for (auto &tail : tails)
+        {
+            work.push_back(tail.get());
+        }
+        while (!work.empty())
+        {
+            auto state = work.back();
+            work.pop_back();
+            if (!state || !candidate[state] || kept[state])
+            {
+                continue;
+            }
+            kept[state] = true;
+            if (state->ch == static_cast<int>(State::Type::Split))
+            {
+                work.push_back(state->next0.get());
+                work.push_back(state->next1.get());
+            }
+        }
+        return candidate.size() - kept.size();
+    }
+
+    // Split(x->P, x->Q) becomes x->Split(P, Q). The Split is rewritten in place, so arrows into it stay valid.
+    // The states and their in-degrees are collected once per pass, a Split whose closure overlaps an earlier
+    // rewrite of the same pass waits for the next round.
+    bool factor_prefixes()
+    {
+        auto states = detail::collect_states(m_Start);
+        std::map<State *, size_t> inDegree;
+        ++inDegree[m_Start.get()];
+        for (auto &state : states)
+        {
+            for (auto next : {state->next0.get(), state->next1.get()})
+            {
+                if (next)
+                {
+                    ++inDegree[next];
+                }
+            }
+        }
+
+        std::vector<std::pair<StatePtr_t, State>> saved;
+        std::map<State *, bool> touched;
+        for (auto &split : states)
+        {
+            if (!is_split(split) || touched[split.get()])
+            {
+                continue;
+            }
+            StatePtrVec_t inner;
+            auto alts = frontier(split, inner);
+            std::vector<StatePtrVec_t> groups;
+            bool shared{false};
+            for (auto &alt : alts)
+            {
+                auto group = std::find_if(groups.begin(), groups.end(), [&](const StatePtrVec_t &g) {
+                    return detail::is_char_state(alt.get()) && g.front()->ch == alt->ch &&
+                           g.front()->fold == alt->fold;
+                });
+                if (group == groups.end())
+                {
+                    groups.push_back({alt});
+                    continue;
+                }
+                group->push_back(alt);
+                shared = true;
+            }
+            auto isTouched = [&](const StatePtr_t &state) { return touched[state.get()]; };
+            if (!shared || std::any_of(inner.begin(), inner.end(), isTouched) ||
+                std::any_of(alts.begin(), alts.end(), isTouched))
+            {
+                continue;
+            }
+
+            StatePtrVec_t grouped, allTails;
+            std::vector<StatePtrVec_t> tailsOf(groups.size());
+            size_t created{0};
+            for (size_t idx{0}; idx < groups.size(); ++idx)
+            {
+                if (groups[idx].size() == 1)
+                {
+                    continue;
+                }
+                for (auto &state : groups[idx])
+                {
+                    grouped.push_back(state);
+                    if (std::find(tailsOf[idx].begin(), tailsOf[idx].end(), state->next0) == tailsOf[idx].end())
+                    {
+                        tailsOf[idx].push_back(state->next0);
+                    }
+                }
+                created += tailsOf[idx].size(); // the factored char state and the Splits over its tails
+                allTails.insert(allTails.end(), tailsOf[idx].begin(), tailsOf[idx].end());
+            }
+            // the root of the new chain is copied into split, the chain itself needs groups.size() - 2 Splits
+            created = groups.size() >= 2 ? created + groups.size() - 2 : created - 1;
+            // Alternatives that are also reachable from elsewhere (loops mostly) get copied rather than moved,
+            // rewrite only if the program actually shrinks.
+            if (released_states(inner, grouped, allTails, inDegree) <= created)
+            {
+                continue;
+            }
+
+            StatePtrVec_t factored;
+            for (size_t idx{0}; idx < groups.size(); ++idx)
+            {
+                if (groups[idx].size() == 1)
+                {
+                    factored.push_back(groups[idx].front());
+                    continue;
+                }
+                factored.push_back(make_state<State>(groups[idx].front()->ch, make_chain(tailsOf[idx]), nullptr));
+                factored.back()->fold = groups[idx].front()->fold;
+            }
+            saved.emplace_back(split, *split);
+            auto root = make_chain(factored);
+            split->ch = root->ch;
+            split->fold = root->fold;
+            split->next0 = root->next0;
+            split->next1 = root->next1;
+            for (auto range : {&inner, &alts, &allTails})
+            {
+                for (auto &state : *range)
+                {
+                    touched[state.get()] = true;
+                }
+            }
+        }
+        // released_states is an estimate, the pass as a whole is undone if it did not pay off
+        if (!saved.empty() && detail::collect_states(m_Start).size() >= states.size())
+        {
+            for (auto it = saved.rbegin(); it != saved.rend(); ++it)
+            {
+                *it->first = it->second;
+            }
+            return false;
+        }
+        return !saved.empty();
+    }
+
+    // Hash-consing: (labels, next0, next1) identifies a state, Split arrows are unordered.
+    bool merge_equivalent()
+    {
+        bool changed{false};
+        for (bool merged{true}; merged;)
+        {
+            merged = false;
+            std::map<std::tuple<int, int, State *, State *>, StatePtr_t> unique;
+            Redirect_t redirect;
+            for (auto &state : detail::collect_states(m_Start))
+            {
+                auto next0 = state->next0.get(), next1 = state->next1.get();
+                if (is_split(state) && next1 < next0)
+                {
+                    std::swap(next0, next1);
+                }
+                auto it = unique.emplace(std::make_tuple(state->ch, state->fold, next0, next1), state);
+                if (!it.second)
+                {
+                    redirect[state.get()] = it.first->second;
+                }
+            }
+            if (!redirect.empty())
+            {
+                apply(redirect);
+                merged = changed = true;
+            }
+        }
+        return changed;
+    }
+
+  private:
+    StatePtr_t &m_Start;
+};
+
+inline NfaOptStats optimize_nfa(StatePtr_t &start)
+{
+    return NfaOptimizer(start).run();
+}
+
+} // namespace lambda
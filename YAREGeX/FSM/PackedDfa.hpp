@@ -0,0 +1,220 @@
+#pragma once
+
+/**
+ * Compressed DFA transition table (comb-vector / row displacement packing)
+ * Most rows of a real DFA table point to the same target (usually Dead) for nearly every byte class. Each row
+ * keeps only its transitions that differ from the row's default, and the sparse rows are slid into one shared
+ * array at offsets where their entries do not collide. A lookup is one extra load compared to the dense table.
+ * For detail see: Aho, Lam, Sethi & Ullman, Compilers: Principles, Techniques, and Tools
+ *                 (3.9.8, Trading Time for Space).
+ *
+ * Author   : Bora Ilgar
+ * Version  : 0.9.1
+ */
+
+#include "../utility/yaregex_common.h"
+#include "Nfa2Dfa.hpp"
+
+// Lookup of state s on byte class c:
+//
+//     row   = rows[s]                   base offset and default target of s
+//     entry = entries[row.base + c]     check and next side by side, one cache line
+//     next  = entry.check == s ? entry.next : row.fallback
+//
+// The default is a single target rather than a chain of default states, so a lookup never loops.
+
+namespace lambda
+{
+
+struct PackedDfa
+{
+    PackedDfa() = default;
+
+    explicit PackedDfa(const Dfa &dfa) : byte_class(dfa.byte_class), class_count(dfa.class_count), start(dfa.start)
+    {
+#ifdef LDEBUG
+        PROFILE_FUNCTION();
+#endif
+        accept = dfa.accept;
+        m_Rows.resize(dfa.size());
+
+        // Default of a row is its most frequent target, every other transition has to be stored.
+        std::vector<std::vector<uint32_t>> columns(dfa.size());
+        for (size_t state{0}; state < dfa.size(); ++state)
+        {
+            auto row = dfa.table.begin() + state * class_count;
+            std::map<int32_t, uint32_t> frequency;
+            for (uint32_t cls{0}; cls < class_count; ++cls)
+            {
+                ++frequency[row[cls]];
+            }
+            // ties go to the smallest target, i.e. Dead whenever it is among them
+            uint32_t most{0};
+            for (auto &target : frequency)
+            {
+                if (target.second > most)
+                {
+                    most = target.second;
+                    m_Rows[state].fallback = target.first;
+                }
+            }
+            for (uint32_t cls{0}; cls < class_count; ++cls)
+            {
+                if (row[cls] != m_Rows[state].fallback)
+                {
+                    columns[state].push_back(cls);
+                }
+            }
+        }
+
+        // First fit, densest rows first: they are the hardest to place.
+        std::vector<int32_t> order(dfa.size());
+        for (size_t idx{0}; idx < order.size(); ++idx)
+        {
+            order[idx] = static_cast<int32_t>(idx);
+        }
+        std::stable_sort(order.begin(), order.end(),
+                         [&](int32_t lhs, int32_t rhs) { return columns[lhs].size() > columns[rhs].size(); });
+
+        std::vector<bool> used;
+        size_t firstFree{0};
+        for (auto state : order)
+        {
+            auto &cols = columns[state];
+            if (cols.empty())
+            {
+                continue;
+            }
+            size_t base = firstFree > cols.front() ? firstFree - cols.front() : 0;
+            for (;; ++base)
+            {
+                bool fits = std::none_of(cols.begin(), cols.end(), [&](uint32_t cls) {
+                    return base + cls < used.size() && used[base + cls];
+                });
+                if (fits)
+                {
+                    break;
+                }
+            }
+            if (used.size() < base + class_count)
+            {
+                used.resize(base + class_count, false);
+                m_Entries.resize(base + class_count);
+            }
+            for (auto cls : cols)
+            {
+                used[base + cls] = true;
+                m_Entries[base + cls] = {state, dfa.table[state * class_count + cls]};
+            }
+            m_Rows[state].base = static_cast<int32_t>(base);
+            while (firstFree < used.size() && used[firstFree])
+            {
+                ++firstFree;
+            }
+        }
+        // Every row reads class_count entries from its base, rows without entries use base 0.
+        if (m_Entries.size() < class_count)
+        {
+            m_Entries.resize(class_count);
+        }
+        m_Entries.shrink_to_fit();
+    }
+
+    size_t size() const
+    {
+        return accept.size();
+    }
+
+    bool empty() const
+    {
+        return accept.empty();
+    }
+
+    int32_t next_state(int32_t state, uint8_t byte) const
+    {
+        auto &row = m_Rows[state];
+        auto &entry = m_Entries[row.base + byte_class[byte]];
+        return entry.check == state ? entry.next : row.fallback;
+    }
+
+    bool is_accept(int32_t state) const
+    {
+        return state != Dfa::Dead && accept[state];
+    }
+
+    int32_t run(int32_t state, const char *first, const char *last) const
+    {
+        for (; first != last && state != Dfa::Dead; ++first)
+        {
+            state = next_state(state, static_cast<uint8_t>(*first));
+        }
+        return state;
+    }
+
+    // Same semantics as RgxMatch::match: the whole string has to be accepted.
+    bool match(const std::string &checkStr) const
+    {
+#ifdef LDEBUG
+        PROFILE_FUNCTION();
+#endif
+        return is_accept(run(start, checkStr.data(), checkStr.data() + checkStr.size()));
+    }
+
+    // The dense table again, e.g. to renumber the states and pack the result.
+    Dfa unpack() const
+    {
+        Dfa dfa;
+        dfa.byte_class = byte_class;
+        dfa.class_count = class_count;
+        dfa.start = start;
+        dfa.accept = accept;
+        dfa.table.reserve(size() * class_count);
+        for (size_t state{0}; state < size(); ++state)
+        {
+            auto &row = m_Rows[state];
+            for (uint32_t cls{0}; cls < class_count; ++cls)
+            {
+                auto &entry = m_Entries[row.base + cls];
+                dfa.table.push_back(entry.check == static_cast<int32_t>(state) ? entry.next : row.fallback);
+            }
+        }
+        return dfa;
+    }
+
+    // Bytes held by the packed table, not counting the object itself. Compare with Dfa::memory_usage.
+    size_t memory_usage() const
+    {
+        return m_Rows.capacity() * sizeof(Row) + m_Entries.capacity() * sizeof(Entry) +
+               accept.capacity() * sizeof(uint8_t);
+    }
+
+    // Stored transitions, i.e. the ones that differ from their row's default.
+    size_t stored_transitions() const
+    {
+        return static_cast<size_t>(
+            std::count_if(m_Entries.begin(), m_Entries.end(), [](const Entry &entry) { return entry.check >= 0; }));
+    }
+
+    std::array<uint8_t, 256> byte_class{};
+    uint32_t class_count{0};
+    int32_t start{Dfa::Dead};
+    std::vector<uint8_t> accept;
+
+  private:
+    struct Row
+    {
+        int32_t base{0};
+        int32_t fallback{Dfa::Dead};
+    };
+
+    struct Entry
+    {
+        int32_t check{Dfa::Dead}; // owning state, Dead for a free slot
+        int32_t next{Dfa::Dead};
+    };
+
+    std::vector<Row> m_Rows;
+    std::vector<Entry> m_Entries;
+};
+
+} // namespace lambda
@@ -0,0 +1,315 @@
+#pragma once
+
+/**
+ * Speculative data-parallel DFA matching of a single input
+ * Splits the input into one chunk per thread. The DFA state a chunk starts in is only known once every
+ * chunk before it has been scanned, so each chunk is scanned from every DFA state at once (or from a small
+ * speculated set for large DFAs) and the resulting state mappings are chained together afterwards.
+ * For detail see: Mytkowicz, Musuvathi & Schulte, Data-Parallel Finite-State Machines (ASPLOS 2014).
+ *
+ * Author   : Bora Ilgar
+ * Version  : 0.9.1
+ */
+
+#include "../utility/yaregex_common.h"
+#include "Nfa2Dfa.hpp"
+#include <atomic>
+#include <numeric>
+#include <thread>
+
+// Scanning from every state sounds like S times the work, but different start states usually run into
+// the same DFA state within a few bytes and from then on share one path: paths are merged as soon as they
+// meet. Merged paths keep their own accept count through an offset. Nothing forces them to meet though, a
+// DFA whose transitions only permute its states ((a|b).(a|b)...)* never merges, so if more paths than the
+// speculated ones are still apart after ConvergeBytes bytes the others are dropped and the chunk goes on
+// from the speculated start states only.
+//
+// The per-chunk mappings compose associatively; a single query only needs the image of the start state,
+// so the prefix over the chunks is a walk of N lookups instead of a parallel scan.
+
+namespace lambda
+{
+
+struct ParallelMatch
+{
+    // Above this many DFA states chunks are scanned from a speculated set instead of every state.
+    static constexpr size_t MaxAllStates = 32;
+    // Bytes before a chunk used to guess the state the chunk starts in.
+    static constexpr size_t Lookback = 64;
+    // Bytes a chunk is scanned from every state before the paths that did not merge are given up.
+    static constexpr size_t ConvergeBytes = 256;
+
+    // The matcher keeps its own copy of dfa, move it in to avoid the copy. threads == 0 uses every hardware
+    // thread. Inputs shorter than two chunks of minChunk bytes are scanned on the calling thread.
+    ParallelMatch(Dfa dfa, unsigned threads = 0, size_t minChunk = 1 << 16, size_t maxAllStates = MaxAllStates)
+        : m_Dfa(std::move(dfa)), m_Threads(threads ? threads : std::max(1u, std::thread::hardware_concurrency())),
+          m_MinChunk(std::max<size_t>(minChunk, 1)), m_MaxAllStates(maxAllStates)
+    {
+        assert(!m_Dfa.empty());
+    }
+
+    // Same semantics as RgxMatch::match: the whole string has to be accepted.
+    bool match(const std::string &checkStr) const
+    {
+#ifdef LDEBUG
+        PROFILE_FUNCTION();
+#endif
+        return m_Dfa.is_accept(scan(checkStr).state);
+    }
+
+    // Number of non-empty prefixes of checkStr the pattern accepts.
+    uint64_t count(const std::string &checkStr) const
+    {
+#ifdef LDEBUG
+        PROFILE_FUNCTION();
+#endif
+        return scan(checkStr).count;
+    }
+
+    // Chunks whose speculated start states missed and had to be rescanned by the last query to finish.
+    // match and count may run concurrently, each query counts on its own and publishes the total at the end.
+    size_t mispredictions() const
+    {
+        return m_Mispredictions.load(std::memory_order_relaxed);
+    }
+
+    // DFA transitions the last query to finish took on all threads together, rescans included. A sequential
+    // scan takes one per byte.
+    uint64_t transitions() const
+    {
+        return m_Transitions.load(std::memory_order_relaxed);
+    }
+
+  private:
+    struct Outcome
+    {
+        int32_t state;
+        uint64_t count;
+    };
+
+    // Mapping of one chunk: starts[i] -> outcomes[i]
+    struct ChunkMap
+    {
+        std::vector<int32_t> starts;
+        std::vector<Outcome> outcomes;
+        uint64_t transitions{0};
+    };
+
+    Outcome run_sequential(int32_t state, const char *first, const char *last, uint64_t &transitions) const
+    {
+        uint64_t count{0};
+        auto begin = first;
+        for (; first != last && state != Dfa::Dead; ++first)
+        {
+            state = m_Dfa.next_state(state, static_cast<uint8_t>(*first));
+            count += m_Dfa.is_accept(state);
+        }
+        transitions += static_cast<uint64_t>(first - begin);
+        return {state, count};
+    }
+
+    // Scans [first, last) from every state in starts, merging paths that meet. Paths still apart after
+    // ConvergeBytes bytes are dropped unless they carry one of the speculated states, see speculated_starts.
+    ChunkMap run_chunk(std::vector<int32_t> &&starts, const std::vector<int32_t> &speculated, const char *first,
+                       const char *last) const
+    {
+        struct Path
+        {
+            int32_t state;
+            uint64_t count;
+            std::vector<uint32_t> members; // indices into starts
+        };
+
+        ChunkMap map;
+        map.outcomes.resize(starts.size());
+        std::vector<int64_t> offset(starts.size(), 0);
+        std::vector<Path> paths;
+        for (uint32_t idx{0}; idx < starts.size(); ++idx)
+        {
+            paths.push_back({starts[idx], 0, {idx}});
+        }
+        std::vector<int32_t> owner(m_Dfa.size(), -1);
+        auto finish = [&](const Path &path) {
+            for (auto member : path.members)
+            {
+                map.outcomes[member] = {path.state, static_cast<uint64_t>(path.count + offset[member])};
+            }
+        };
+
+        std::vector<bool> dropped(starts.size(), false);
+        auto begin = first;
+        for (; first != last && !paths.empty(); ++first)
+        {
+            if (static_cast<size_t>(first - begin) == ConvergeBytes && paths.size() > speculated.size())
+            {
+                auto kept = std::remove_if(paths.begin(), paths.end(), [&](const Path &path) {
+                    return std::none_of(path.members.begin(), path.members.end(), [&](uint32_t member) {
+                        return std::find(speculated.begin(), speculated.end(), starts[member]) != speculated.end();
+                    });
+                });
+                for (auto it = kept; it != paths.end(); ++it)
+                {
+                    for (auto member : it->members)
+                    {
+                        dropped[member] = true;
+                    }
+                }
+                paths.erase(kept, paths.end());
+                // owner indices refer to the old positions
+                std::fill(owner.begin(), owner.end(), -1);
+                for (size_t idx{0}; idx < paths.size(); ++idx)
+                {
+                    owner[paths[idx].state] = static_cast<int32_t>(idx);
+                }
+            }
+            map.transitions += paths.size();
+            auto byte = static_cast<uint8_t>(*first);
+            size_t live{0};
+            for (size_t idx{0}; idx < paths.size(); ++idx)
+            {
+                auto &path = paths[idx];
+                path.state = m_Dfa.next_state(path.state, byte);
+                if (path.state == Dfa::Dead)
+                {
+                    finish(path);
+                    continue;
+                }
+                path.count += m_Dfa.is_accept(path.state);
+
+                // Same state as an earlier path: the futures are identical from here on.
+                auto &earlier = owner[path.state];
+                if (earlier >= 0 && static_cast<size_t>(earlier) < live && paths[earlier].state == path.state)
+                {
+                    auto &into = paths[earlier];
+                    for (auto member : path.members)
+                    {
+                        offset[member] += static_cast<int64_t>(path.count) - static_cast<int64_t>(into.count);
+                    }
+                    into.members.insert(into.members.end(), path.members.begin(), path.members.end());
+                    continue;
+                }
+                earlier = static_cast<int32_t>(live);
+                if (live != idx)
+                {
+                    paths[live] = std::move(path);
+                }
+                ++live;
+            }
+            paths.resize(live);
+        }
+        for (auto &path : paths)
+        {
+            finish(path);
+        }
+        size_t kept{0};
+        for (size_t idx{0}; idx < starts.size(); ++idx)
+        {
+            if (!dropped[idx])
+            {
+                starts[kept] = starts[idx];
+                map.outcomes[kept++] = map.outcomes[idx];
+            }
+        }
+        starts.resize(kept);
+        map.outcomes.resize(kept);
+        map.starts = std::move(starts);
+        return map;
+    }
+
+    // Speculated states a chunk starts in: the start state and the state the Lookback bytes before the chunk
+    // lead to from the start state.
+    std::vector<int32_t> speculated_starts(const char *chunkBegin, const char *inputBegin) const
+    {
+        std::vector<int32_t> starts;
+        starts.push_back(m_Dfa.start);
+        auto window = std::min<size_t>(Lookback, static_cast<size_t>(chunkBegin - inputBegin));
+        auto guess = m_Dfa.run(m_Dfa.start, chunkBegin - window, chunkBegin);
+        if (guess != Dfa::Dead && guess != m_Dfa.start)
+        {
+            starts.push_back(guess);
+        }
+        return starts;
+    }
+
+    Outcome scan(const std::string &checkStr) const
+    {
+        const char *first = checkStr.data();
+        const char *last = first + checkStr.size();
+
+        size_t chunks = std::min<size_t>(m_Threads, checkStr.size() / m_MinChunk);
+        if (chunks <= 1)
+        {
+            uint64_t transitions{0};
+            auto result = run_sequential(m_Dfa.start, first, last, transitions);
+            m_Mispredictions.store(0, std::memory_order_relaxed);
+            m_Transitions.store(transitions, std::memory_order_relaxed);
+            return result;
+        }
+
+        size_t chunkSize = checkStr.size() / chunks;
+        std::vector<const char *> bounds;
+        for (size_t idx{0}; idx < chunks; ++idx)
+        {
+            bounds.push_back(first + idx * chunkSize);
+        }
+        bounds.push_back(last);
+
+        // Chunk 0 starts in the start state for sure, it runs on the calling thread.
+        std::vector<ChunkMap> maps(chunks);
+        std::vector<std::thread> workers;
+        for (size_t idx{1}; idx < chunks; ++idx)
+        {
+            workers.emplace_back([&, idx] {
+                // every state for small DFAs, only the speculated ones otherwise
+                auto speculated = speculated_starts(bounds[idx], first);
+                auto starts = speculated;
+                if (m_Dfa.size() <= m_MaxAllStates)
+                {
+                    starts.resize(m_Dfa.size());
+                    std::iota(starts.begin(), starts.end(), 0);
+                }
+                maps[idx] = run_chunk(std::move(starts), speculated, bounds[idx], bounds[idx + 1]);
+            });
+        }
+        uint64_t transitions{0};
+        Outcome result = run_sequential(m_Dfa.start, bounds[0], bounds[1], transitions);
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+
+        for (size_t idx{1}; idx < chunks; ++idx)
+        {
+            transitions += maps[idx].transitions;
+        }
+        size_t mispredictions{0};
+        for (size_t idx{1}; idx < chunks && result.state != Dfa::Dead; ++idx)
+        {
+            auto &map = maps[idx];
+            auto it = std::find(map.starts.begin(), map.starts.end(), result.state);
+            Outcome outcome;
+            if (it != map.starts.end())
+            {
+                outcome = map.outcomes[it - map.starts.begin()];
+            }
+            else
+            {
+                ++mispredictions;
+                outcome = run_sequential(result.state, bounds[idx], bounds[idx + 1], transitions);
+            }
+            result = {outcome.state, result.count + outcome.count};
+        }
+        m_Mispredictions.store(mispredictions, std::memory_order_relaxed);
+        m_Transitions.store(transitions, std::memory_order_relaxed);
+        return result;
+    }
+
+  private:
+    Dfa m_Dfa;
+    unsigned m_Threads;
+    size_t m_MinChunk, m_MaxAllStates;
+    mutable std::atomic<size_t> m_Mispredictions{0};
+    mutable std::atomic<uint64_t> m_Transitions{0};
+};
+
+} // namespace lambda
@@ -10,6 +10,7 @@
  */
 
 #include "../regex_handler/Rgx2Postfix.hpp"
+#include "../utility/Arena.hpp"
 #include "../utility/yaregex_common.h"
 
 namespace lambda
@@ -33,10 +34,32 @@ struct State
         : ch(data), next0(n0), next1(n1)
     {
     }
-    int ch, last_list{0};
+    int ch;
+    // Generation of the RgxMatch list the state was last added to, 64 bit so that the process-wide
+    // counter never wraps back onto a stale value.
+    uint64_t last_list{0};
+    // Second byte accepted by a char state, -1 if none. Set by make_nfa for RgxFlags::IgnoreCase
+    // so that both cases of a letter share one state instead of a Split over two.
+    int fold{-1};
     std::shared_ptr<State> next0, next1;
 };
 
+enum class RgxFlags : uint32_t
+{
+    None = 0,
+    IgnoreCase = 1 << 0 // letters match both cases, folded into the automaton at compile time
+};
+
+inline RgxFlags operator|(RgxFlags lhs, RgxFlags rhs)
+{
+    return static_cast<RgxFlags>(static_cast<uint32_t>(lhs) | static_cast<uint32_t>(rhs));
+}
+
+inline bool has_flag(RgxFlags flags, RgxFlags flag)
+{
+    return (static_cast<uint32_t>(flags) & static_cast<uint32_t>(flag)) != 0;
+}
+
 // If any non - static data member of a union has a
 // non - trivial default constructor(12.1),
 // copy constructor(12.8),
@@ -56,8 +79,14 @@ union StateList {
 #endif
 
 using StatePtr_t = std::shared_ptr<State>;
+using StatePtrVec_t = std::vector<StatePtr_t>;
+// Allocates from the arena installed on this thread (see Arena::Scope), from the heap otherwise.
 template <typename T, typename U, typename... Args> StatePtr_t make_state(const U data, Args &&...arg)
 {
+    if (auto &arena = Arena::current())
+    {
+        return std::allocate_shared<T>(ArenaAllocator<T>(arena), static_cast<int>(data), std::forward<Args>(arg)...);
+    }
     return std::make_shared<T>(static_cast<int>(data), std::forward<Args>(arg)...);
 }
 
@@ -160,14 +189,97 @@ struct StateHelper
     }
 };
 
-StatePtr_t make_nfa(RgxString &&postRegex)
+namespace detail
+{
+inline bool is_char_state(const State *state)
+{
+    return state->ch != static_cast<int>(State::Type::Split) && state->ch != static_cast<int>(State::Type::Match);
+}
+
+// True if state is a char state labelled byte (either case of it, for folded states).
+inline bool accepts(const State *state, uint8_t byte)
+{
+    return is_char_state(state) && (static_cast<uint8_t>(state->ch) == byte || state->fold == byte);
+}
+
+// Collects every state reachable from start, Split states included.
+// States are listed in depth-first order, start is always the first element.
+inline StatePtrVec_t collect_states(const StatePtr_t &start)
+{
+    StatePtrVec_t states;
+    StatePtrVec_t work{start};
+    std::map<State *, bool> seen;
+    while (!work.empty())
+    {
+        auto state = work.back();
+        work.pop_back();
+        if (!state || seen[state.get()])
+        {
+            continue;
+        }
+        seen[state.get()] = true;
+        states.push_back(state);
+        work.push_back(state->next1);
+        work.push_back(state->next0);
+    }
+    return states;
+}
+
+// Cuts every arrow of the NFA at start and drops start. A loop makes its states own each other through their
+// shared_ptrs, so an NFA with a closure in it is only freed (and its arena released) this way.
+inline void release_nfa(StatePtr_t &start)
+{
+    for (auto &state : collect_states(start))
+    {
+        state->next0.reset();
+        state->next1.reset();
+    }
+    start.reset();
+}
+
+// e-closure(q): follows the unlabeled arrows of Split states, keeps char and match states only.
+// The result is sorted, make_dfa uses it as the key of a DFA state.
+inline std::vector<State *> closure(const std::vector<State *> &seeds)
+{
+    std::vector<State *> result;
+    std::vector<State *> work(seeds.rbegin(), seeds.rend());
+    std::map<State *, bool> seen;
+    while (!work.empty())
+    {
+        State *state = work.back();
+        work.pop_back();
+        if (!state || seen[state])
+        {
+            continue;
+        }
+        seen[state] = true;
+        if (state->ch == static_cast<int>(State::Type::Split))
+        {
+            work.push_back(state->next1.get());
+            work.push_back(state->next0.get());
+            continue;
+        }
+        result.push_back(state);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+} // namespace detail
+
+inline StatePtr_t make_nfa(RgxString &&postRegex, RgxFlags flags = RgxFlags::None)
 {
     std::stack<NState> nfa_stack;
+    const bool ignoreCase = has_flag(flags, RgxFlags::IgnoreCase);
     for (auto &&ch : postRegex)
     {
-        if (ch >= 'a' && ch <= 'z')
+        if ((ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z'))
         {
             auto statePtr = make_state<State>(ch);
+            if (ignoreCase)
+            {
+                // ASCII: the two cases differ in bit 0x20 only
+                statePtr->fold = ch ^ 0x20;
+            }
             nfa_stack.emplace(statePtr, StateHelper::Funcs().create_list(&statePtr->next0));
         }
         if (ch == '.')
@@ -0,0 +1,140 @@
+#pragma once
+
+/**
+ * Parallel compilation of pattern sets
+ * Compiles a whole rule set at once: tokenizing, the postfix conversion, make_nfa and the planner (including
+ * subset construction) run for many patterns side by side on a work-stealing pool. Every worker builds its
+ * NFA states in an arena of its own, so the threads do not contend on the heap.
+ *
+ * Author   : Bora Ilgar
+ * Version  : 0.9.1
+ */
+
+#include "../utility/Arena.hpp"
+#include "../utility/yaregex_common.h"
+#include "RgxPlanner.hpp"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+// Each worker starts on its own contiguous share of the patterns and takes them from the front. A worker that
+// runs out steals from the back of the share with the most work left, so a handful of slow patterns (big
+// subset constructions) do not hold up the ones queued behind them and the whole set takes about as long as
+// the slowest pattern once there are enough threads.
+
+namespace lambda
+{
+
+struct RgxCompileResult
+{
+    std::unique_ptr<RgxProgram> program; // null if the pattern could not be compiled
+    std::string error;                   // why, empty on success
+
+    bool ok() const
+    {
+        return program != nullptr;
+    }
+};
+
+namespace detail
+{
+// Share of the task indices owned by one worker: [begin, end).
+struct TaskRange
+{
+    std::mutex lock;
+    size_t begin{0}, end{0};
+};
+
+// Next index for worker self: from the front of its own range, otherwise from the back of the fullest other.
+inline bool next_task(std::vector<TaskRange> &ranges, size_t self, size_t &task)
+{
+    {
+        std::lock_guard<std::mutex> guard(ranges[self].lock);
+        if (ranges[self].begin < ranges[self].end)
+        {
+            task = ranges[self].begin++;
+            return true;
+        }
+    }
+    for (;;)
+    {
+        size_t victim{self}, most{0};
+        for (size_t idx{0}; idx < ranges.size(); ++idx)
+        {
+            std::lock_guard<std::mutex> guard(ranges[idx].lock);
+            if (ranges[idx].end - ranges[idx].begin > most)
+            {
+                most = ranges[idx].end - ranges[idx].begin;
+                victim = idx;
+            }
+        }
+        if (most == 0)
+        {
+            return false;
+        }
+        std::lock_guard<std::mutex> guard(ranges[victim].lock);
+        // someone else may have emptied it since it was picked
+        if (ranges[victim].begin < ranges[victim].end)
+        {
+            task = --ranges[victim].end;
+            return true;
+        }
+    }
+}
+
+inline RgxCompileResult compile_one(const std::string &pattern, const RgxPlanOptions &options)
+{
+    RgxCompileResult result;
+    result.program = std::make_unique<RgxProgram>(RgxString(pattern), options);
+    if (!result.program->error().empty())
+    {
+        result.error = result.program->error();
+        result.program.reset();
+    }
+    return result;
+}
+} // namespace detail
+
+// Compiles every pattern with options, results are in the order of patterns. A malformed pattern only fails
+// its own entry. threads == 0 uses every hardware thread.
+inline std::vector<RgxCompileResult> compile_all(const std::vector<std::string> &patterns,
+                                                 const RgxPlanOptions &options = {}, unsigned threads = 0)
+{
+#ifdef LDEBUG
+    PROFILE_FUNCTION();
+#endif
+    std::vector<RgxCompileResult> results(patterns.size());
+    size_t workers = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+    workers = std::max<size_t>(1, std::min(workers, patterns.size()));
+
+    std::vector<detail::TaskRange> ranges(workers);
+    for (size_t idx{0}; idx < workers; ++idx)
+    {
+        ranges[idx].begin = patterns.size() * idx / workers;
+        ranges[idx].end = patterns.size() * (idx + 1) / workers;
+    }
+
+    auto work = [&](size_t self) {
+        Arena::Scope scope(std::make_shared<Arena>());
+        size_t task;
+        while (detail::next_task(ranges, self, task))
+        {
+            results[task] = detail::compile_one(patterns[task], options);
+        }
+    };
+
+    // Worker 0 is the calling thread.
+    std::vector<std::thread> pool;
+    for (size_t idx{1}; idx < workers; ++idx)
+    {
+        pool.emplace_back(work, idx);
+    }
+    work(0);
+    for (auto &worker : pool)
+    {
+        worker.join();
+    }
+    return results;
+}
+
+} // namespace lambda
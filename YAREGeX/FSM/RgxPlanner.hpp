@@ -0,0 +1,470 @@
+#pragma once
+
+/**
+ * Engine selection for a compiled pattern
+ * Analyzes the postfix string and the NFA of a pattern and picks the cheapest engine that can run it:
+ * plain string compare, DFA table walk, bit-parallel simulation or Thompson's NFA simulation.
+ *
+ * Author   : Bora Ilgar
+ * Version  : 0.9.1
+ */
+
+#include "../utility/yaregex_common.h"
+#include "BitParallel.hpp"
+#include "DfaLayout.hpp"
+#include "LazyDfa.hpp"
+#include "Nfa2Dfa.hpp"
+#include "NfaMatcher.hpp"
+#include "NfaOptimizer.hpp"
+#include "PackedDfa.hpp"
+#include <sstream>
+
+namespace lambda
+{
+
+enum class RgxEngine
+{
+    Auto = 0,    // let the planner decide
+    Literal,     // pattern is a plain string, std::string compare
+    Dfa,         // one table load per byte
+    PackedDfa,   // Dfa with a compressed table, two loads per byte
+    BitParallel, // a few AND/OR per byte, no construction blow-up
+    LazyDfa,     // DFA states built on demand within a memory budget, falls back to RgxMatch
+    Nfa          // RgxMatch, always applicable
+};
+
+inline const char *engine_name(RgxEngine engine)
+{
+    switch (engine)
+    {
+    case RgxEngine::Literal:
+        return "Literal";
+    case RgxEngine::Dfa:
+        return "Dfa";
+    case RgxEngine::PackedDfa:
+        return "PackedDfa";
+    case RgxEngine::BitParallel:
+        return "BitParallel";
+    case RgxEngine::LazyDfa:
+        return "LazyDfa";
+    case RgxEngine::Nfa:
+        return "Nfa";
+    default:
+        return "Auto";
+    }
+}
+
+struct RgxPlanOptions
+{
+    RgxEngine engine{RgxEngine::Auto}; // forces an engine, the planner falls back if it is not applicable
+    bool optimize{true};               // run NfaOptimizer before analysis
+    RgxFlags flags{RgxFlags::None};    // passed to make_nfa
+    size_t small_dfa_states{64};       // a DFA this small is preferred over the bit-parallel engine
+    size_t max_dfa_states{4096};       // above this subset construction is abandoned
+    size_t packed_dfa_bytes{1 << 16};  // a dense DFA table above this is packed if that saves memory
+    size_t dfa_cache_budget{LazyDfa::DefaultBudget}; // hard cap on the bytes held by the LazyDfa state cache
+    size_t dfa_cache_max_clears{LazyDfa::DefaultMaxClears};
+};
+
+// What the planner knows about a pattern.
+struct RgxAnalysis
+{
+    std::string postfix;
+    bool literal{false};     // only letters and concatenation
+    std::string literal_text;
+    size_t nfa_states{0};    // after optimization, match-state included
+    size_t positions{0};     // char states, i.e. bits needed by BitParallel
+    size_t dfa_states{0};    // zero if no DFA was built
+    bool dfa_trained{false}; // DFA states are in hot-first order (RgxProgram::train or load_layout)
+    bool anchored{true};     // match() is a whole-string match, there is no unanchored search yet
+    bool captures{false};    // parentheses only group, nothing is captured
+};
+
+struct RgxPlan
+{
+    RgxEngine engine{RgxEngine::Nfa};
+    RgxEngine requested{RgxEngine::Auto};
+    std::string reason;
+    std::string error; // why the pattern was rejected, empty if it compiled
+    RgxAnalysis analysis;
+    NfaOptStats optimization;
+
+    std::string explain() const
+    {
+        std::ostringstream os;
+        os << "postfix    : " << analysis.postfix << '\n';
+        os << "engine     : " << engine_name(engine);
+        if (requested != RgxEngine::Auto)
+        {
+            os << " (requested " << engine_name(requested) << ')';
+        }
+        os << '\n';
+        os << "reason     : " << reason << '\n';
+        os << "nfa states : " << optimization.states_before << " -> " << analysis.nfa_states << " ("
+           << analysis.positions << " positions)" << '\n';
+        os << "dfa states : " << analysis.dfa_states << (analysis.dfa_trained ? " (trained layout)" : "") << '\n';
+        os << "literal    : " << (analysis.literal ? "yes" : "no") << '\n';
+        os << "anchored   : " << (analysis.anchored ? "yes" : "no") << '\n';
+        os << "captures   : " << (analysis.captures ? "yes" : "no") << '\n';
+        return os.str();
+    }
+};
+
+// A pattern compiled for the engine chosen by the planner.
+//
+//     auto program = lambda::make_program({"a.(a|b)*.b"});
+//     program.match("abab");
+//     std::cout << program.explain();
+struct RgxProgram
+{
+    // A malformed pattern (see RgxString::error) builds nothing: error() tells why and match() is always false.
+    explicit RgxProgram(RgxString &&postRegex, const RgxPlanOptions &options = {})
+    {
+#ifdef LDEBUG
+        PROFILE_FUNCTION();
+#endif
+        m_Options = options;
+        m_Plan.requested = options.engine;
+        if (!postRegex.error().empty())
+        {
+            // the empty Dfa starts in Dead, so nothing matches
+            m_Plan.error = postRegex.error();
+            m_Plan.reason = "invalid pattern: " + m_Plan.error;
+            m_Plan.engine = RgxEngine::Dfa;
+            return;
+        }
+        auto &analysis = m_Plan.analysis;
+        analysis.literal = true;
+        for (auto ch : postRegex)
+        {
+            analysis.postfix.push_back(ch);
+            if (ch == '.')
+            {
+                continue;
+            }
+            if ((ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z'))
+            {
+                analysis.literal_text.push_back(ch);
+                continue;
+            }
+            analysis.literal = false;
+        }
+
+        m_Nfa = make_nfa(std::move(postRegex), options.flags);
+        if (options.optimize)
+        {
+            m_Plan.optimization = optimize_nfa(m_Nfa);
+        }
+        else
+        {
+            m_Plan.optimization.states_before = m_Plan.optimization.states_after =
+                detail::collect_states(m_Nfa).size();
+        }
+        analysis.nfa_states = m_Plan.optimization.states_after;
+        analysis.positions = BitParallel::positions(m_Nfa);
+
+        if (options.engine == RgxEngine::Auto || !try_engine(options.engine, options.max_dfa_states))
+        {
+            choose(options);
+        }
+    }
+
+    // The NFA is owned by the program, its states are released (and their cycles cut) with it.
+    ~RgxProgram()
+    {
+        detail::release_nfa(m_Nfa);
+    }
+
+    RgxProgram(const RgxProgram &) = delete;
+    RgxProgram &operator=(const RgxProgram &) = delete;
+
+    bool match(const std::string &checkStr)
+    {
+        switch (m_Plan.engine)
+        {
+        case RgxEngine::Literal:
+            return has_flag(m_Options.flags, RgxFlags::IgnoreCase) ? equals_ignore_case(checkStr)
+                                                                   : checkStr == m_Plan.analysis.literal_text;
+        case RgxEngine::Dfa:
+            return m_Dfa.match(checkStr);
+        case RgxEngine::PackedDfa:
+            return m_PackedDfa.match(checkStr);
+        case RgxEngine::BitParallel:
+            return m_BitParallel->match(checkStr);
+        case RgxEngine::LazyDfa:
+            return m_LazyDfa->match(checkStr);
+        default:
+            return m_NfaMatch->match(checkStr);
+        }
+    }
+
+    const RgxPlan &plan() const
+    {
+        return m_Plan;
+    }
+
+    // Why the pattern was rejected, empty if it compiled.
+    const std::string &error() const
+    {
+        return m_Plan.error;
+    }
+
+    std::string explain() const
+    {
+        return m_Plan.explain();
+    }
+
+    const StatePtr_t &nfa() const
+    {
+        return m_Nfa;
+    }
+
+    // Bytes currently held by the program: NFA states plus whatever the engine allocated.
+    // For LazyDfa this changes while matching but never exceeds RgxPlanOptions::dfa_cache_budget.
+    size_t memory_usage() const
+    {
+        // shared_ptr control block is allocated together with the State by make_shared
+        size_t memory = m_Plan.analysis.nfa_states * (sizeof(State) + 2 * sizeof(void *));
+        memory += m_Dfa.memory_usage() + m_PackedDfa.memory_usage();
+        if (m_BitParallel)
+        {
+            memory += sizeof(BitParallel);
+        }
+        if (m_LazyDfa)
+        {
+            memory += m_LazyDfa->memory_usage();
+        }
+        return memory;
+    }
+
+    // Renumbers the DFA states hottest first by how often samples visit them, see DfaLayout.hpp.
+    // Only the Dfa and PackedDfa engines of a valid pattern have a table to lay out, returns false otherwise.
+    // A packed table is unpacked, renumbered and packed again.
+    bool train(const std::vector<std::string> &samples)
+    {
+        if (!has_dfa_table())
+        {
+            return false;
+        }
+        auto dense = m_Plan.engine == RgxEngine::PackedDfa ? m_PackedDfa.unpack() : std::move(m_Dfa);
+        DfaProfile profile(dense);
+        for (auto &sample : samples)
+        {
+            profile.record(sample);
+        }
+        set_dfa_table(reorder_dfa(dense, profile));
+        m_Plan.analysis.dfa_trained = true;
+        return true;
+    }
+
+    // Writes the DFA in its current layout so another process can load it instead of training again.
+    // A packed table is written unpacked, the image does not depend on packed_dfa_bytes.
+    bool save_layout(std::ostream &os) const
+    {
+        if (!has_dfa_table())
+        {
+            return false;
+        }
+        if (m_Plan.engine == RgxEngine::PackedDfa)
+        {
+            save_dfa(os, m_PackedDfa.unpack());
+        }
+        else
+        {
+            save_dfa(os, m_Dfa);
+        }
+        return static_cast<bool>(os);
+    }
+
+    // Loads a layout written by save_layout. It is only taken if it is the same automaton as the compiled one,
+    // a layout saved for another pattern or with other options is rejected and the program stays as it was.
+    bool load_layout(std::istream &is)
+    {
+        Dfa loaded, unpacked;
+        if (!has_dfa_table() || !load_dfa(is, loaded))
+        {
+            return false;
+        }
+        if (m_Plan.engine == RgxEngine::PackedDfa)
+        {
+            unpacked = m_PackedDfa.unpack();
+        }
+        if (!detail::same_automaton(m_Plan.engine == RgxEngine::PackedDfa ? unpacked : m_Dfa, loaded))
+        {
+            return false;
+        }
+        set_dfa_table(std::move(loaded));
+        m_Plan.analysis.dfa_trained = true;
+        return true;
+    }
+
+    // Null unless the plan uses the LazyDfa engine.
+    const LazyDfa *lazy_dfa() const
+    {
+        return m_LazyDfa.get();
+    }
+
+  private:
+    // A rejected pattern runs on an empty Dfa that has no layout to train or save.
+    bool has_dfa_table() const
+    {
+        return m_Plan.error.empty() && (m_Plan.engine == RgxEngine::Dfa || m_Plan.engine == RgxEngine::PackedDfa);
+    }
+
+    // Installs dfa as the table of the current engine, packing it for PackedDfa.
+    void set_dfa_table(Dfa &&dfa)
+    {
+        if (m_Plan.engine == RgxEngine::PackedDfa)
+        {
+            m_PackedDfa = PackedDfa(dfa);
+            return;
+        }
+        m_Dfa = std::move(dfa);
+    }
+
+    // Compares in place, the input is never lowercased into a copy.
+    bool equals_ignore_case(const std::string &checkStr) const
+    {
+        auto &literal = m_Plan.analysis.literal_text;
+        if (checkStr.size() != literal.size())
+        {
+            return false;
+        }
+        for (size_t idx{0}; idx < literal.size(); ++idx)
+        {
+            // literal holds letters only, so folding bit 0x20 is enough
+            if ((checkStr[idx] | 0x20) != (literal[idx] | 0x20))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Cheapest first: Literal, a small DFA, BitParallel, a DFA of up to max_dfa_states states (packed if large),
+    // a DFA cached within the memory budget. An engine that was requested and failed is not tried again.
+    // Subset construction is abandoned as soon as it needs more than dfa_cache_budget bytes, so a pattern
+    // whose DFA ends up on the cache never costs more than the cache would.
+    void choose(const RgxPlanOptions &options)
+    {
+        bool dfaFailed = options.engine == RgxEngine::Dfa || options.engine == RgxEngine::PackedDfa;
+        if (options.engine != RgxEngine::Literal && try_engine(RgxEngine::Literal, 0))
+        {
+            return;
+        }
+        if (m_Plan.analysis.positions <= BitParallel::MaxPositions)
+        {
+            if (!dfaFailed && try_engine(RgxEngine::Dfa, options.small_dfa_states, options.dfa_cache_budget))
+            {
+                return;
+            }
+            try_engine(RgxEngine::BitParallel, 0);
+            return;
+        }
+        if (!dfaFailed && try_engine(RgxEngine::Dfa, options.max_dfa_states, options.dfa_cache_budget))
+        {
+            return;
+        }
+        try_engine(RgxEngine::LazyDfa, 0);
+    }
+
+    // Replaces the dense table by a PackedDfa if forced or if the packed one is smaller.
+    RgxEngine pack_dfa(bool forced, std::ostringstream &reason)
+    {
+        PackedDfa packed(m_Dfa);
+        auto dense = m_Dfa.memory_usage();
+        if (!forced && packed.memory_usage() >= dense)
+        {
+            reason << ", " << dense << " byte table does not pack smaller";
+            return RgxEngine::Dfa;
+        }
+        reason << ", " << dense << " byte table packed to " << packed.memory_usage() << " bytes";
+        m_PackedDfa = std::move(packed);
+        m_Dfa = Dfa();
+        return RgxEngine::PackedDfa;
+    }
+
+    // Sets up engine if it can run this pattern, records why in the plan either way.
+    bool try_engine(RgxEngine engine, size_t maxDfaStates, size_t maxDfaBytes = static_cast<size_t>(-1))
+    {
+        auto &analysis = m_Plan.analysis;
+        std::ostringstream reason;
+        if (!m_Plan.reason.empty())
+        {
+            reason << m_Plan.reason << "; ";
+        }
+        bool viable{false};
+        switch (engine)
+        {
+        case RgxEngine::Literal:
+            viable = analysis.literal;
+            reason << (viable ? "pattern is a plain string" : "pattern has operators other than concatenation");
+            break;
+        case RgxEngine::Dfa:
+        case RgxEngine::PackedDfa:
+            m_Dfa = make_dfa(m_Nfa, maxDfaStates, maxDfaBytes);
+            viable = !m_Dfa.empty();
+            analysis.dfa_states = m_Dfa.size();
+            if (!viable)
+            {
+                reason << "subset construction exceeded " << maxDfaStates << " states";
+                if (maxDfaBytes != static_cast<size_t>(-1))
+                {
+                    reason << " or " << maxDfaBytes << " bytes";
+                }
+                break;
+            }
+            reason << "subset construction gave " << m_Dfa.size() << " states";
+            if (engine == RgxEngine::PackedDfa || m_Dfa.memory_usage() > m_Options.packed_dfa_bytes)
+            {
+                engine = pack_dfa(engine == RgxEngine::PackedDfa, reason);
+            }
+            break;
+        case RgxEngine::BitParallel:
+            viable = analysis.positions <= BitParallel::MaxPositions;
+            if (viable)
+            {
+                m_BitParallel = std::make_unique<BitParallel>(m_Nfa);
+                reason << analysis.positions << " positions fit in a 64 bit word";
+            }
+            else
+            {
+                reason << analysis.positions << " positions do not fit in a 64 bit word";
+            }
+            break;
+        case RgxEngine::LazyDfa:
+            viable = true;
+            m_LazyDfa = std::make_unique<LazyDfa>(m_Nfa, m_Options.dfa_cache_budget, m_Options.dfa_cache_max_clears);
+            reason << "DFA states cached within " << m_Options.dfa_cache_budget << " bytes";
+            break;
+        default:
+            viable = true;
+            m_NfaMatch = std::make_unique<RgxMatch>(m_Nfa);
+            reason << "simulating the NFA";
+            break;
+        }
+        m_Plan.reason = reason.str();
+        if (viable)
+        {
+            m_Plan.engine = engine;
+        }
+        return viable;
+    }
+
+  private:
+    RgxPlan m_Plan;
+    StatePtr_t m_Nfa;
+    Dfa m_Dfa;
+    PackedDfa m_PackedDfa;
+    std::unique_ptr<BitParallel> m_BitParallel;
+    std::unique_ptr<LazyDfa> m_LazyDfa;
+    std::unique_ptr<RgxMatch> m_NfaMatch;
+    RgxPlanOptions m_Options;
+};
+
+inline RgxProgram make_program(RgxString &&postRegex, const RgxPlanOptions &options = {})
+{
+    return RgxProgram(std::move(postRegex), options);
+}
+
+} // namespace lambda
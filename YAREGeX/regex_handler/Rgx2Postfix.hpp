@@ -30,6 +30,7 @@ struct RgxString
         // Operators
         enum class operator_type : int16_t
         {
+            UNKNOWN = -1,  // not an operator nor a letter (e.g. the terminating '\0'), skipped
             ALPHABET = 0,  //[a-z]|[A-Z]
             L_PARANTHESIS, //(
             R_PARANTHESIS, //)
@@ -46,9 +47,9 @@ struct RgxString
         {
         }
 
-        operator_type m_OpType;
-        uint8_t m_Ch;
-        int m_Presedence;
+        operator_type m_OpType{operator_type::UNKNOWN};
+        uint8_t m_Ch{0};
+        int m_Presedence{-1};
     };
 
     // Prepare tokens by all char elem by it' s presedence and types
@@ -59,50 +60,23 @@ struct RgxString
 
         for (int idx{0}; idx < CArraySize; ++idx)
         {
-            if (is_letter(ar[idx]))
-            {
-                Token tkn(Token::operator_type::ALPHABET, ar[idx]);
-                tokens[idx] = tkn;
-            }
+            tokens[idx] = make_token(ar[idx]);
+        }
+        calculate_postfix_from(tokens);
+    }
 
-            if (ar[idx] == '(')
-            {
-                Token tkn(Token::operator_type::L_PARANTHESIS, ar[idx]);
-                tokens[idx] = tkn;
-            }
-            if (ar[idx] == ')')
-            {
-                Token tkn(Token::operator_type::R_PARANTHESIS, ar[idx]);
-                tokens[idx] = tkn;
-            }
-            if (ar[idx] == '*')
-            {
-                Token tkn(Token::operator_type::CLOSURE, ar[idx], 4);
-                tokens[idx] = tkn;
-            }
-            if (ar[idx] == '|')
-            {
-                Token tkn(Token::operator_type::UNION, ar[idx], 1);
-                tokens[idx] = tkn;
-            }
-            if (ar[idx] == '?')
-            {
-                Token tkn(Token::operator_type::ZERO_OR_MORE, ar[idx], 3);
-                tokens[idx] = tkn;
-            }
-            if (ar[idx] == '+')
-            {
-                Token tkn(Token::operator_type::ONE_OR_MORE, ar[idx], 3);
-                tokens[idx] = tkn;
-            }
-            // The concatenation expression usually does not have a symbol between the two letters ab. This will make
-            // our computation more difficult than necessary when compute the conversation. So, in order to easily
-            // handle this will be using an . symbol between the two letters for every concatenation.
-            // So, ab will now turn into a.b
-            if (ar[idx] == '.')
+    // Same for a pattern only known at run time (e.g. loaded from a rule file).
+    // Check error() before passing it to make_nfa.
+    explicit RgxString(const std::string &pattern)
+    {
+        std::vector<Token> tokens;
+        tokens.reserve(pattern.size());
+        for (size_t idx{0}; idx < pattern.size(); ++idx)
+        {
+            tokens.push_back(make_token(pattern[idx]));
+            if (tokens.back().m_OpType == Token::operator_type::UNKNOWN && m_Error.empty())
             {
-                Token tkn(Token::operator_type::CONCAT, ar[idx], 2);
-                tokens[idx] = tkn;
+                m_Error = std::string("unsupported character '") + pattern[idx] + "' at " + std::to_string(idx);
             }
         }
         calculate_postfix_from(tokens);
@@ -121,10 +95,47 @@ struct RgxString
 
     friend std::ostream &operator<<(std::ostream &os, const RgxString &rString);
 
+    // Empty if the pattern is well formed, otherwise what is wrong with it. make_nfa expects a well formed pattern.
+    const std::string &error() const
+    {
+        return m_Error;
+    }
+
   private:
+    // The concatenation expression usually does not have a symbol between the two letters ab. This will make
+    // our computation more difficult than necessary when compute the conversation. So, in order to easily
+    // handle this will be using an . symbol between the two letters for every concatenation.
+    // So, ab will now turn into a.b
+    Token make_token(const char ch)
+    {
+        if (is_letter(ch))
+        {
+            return Token(Token::operator_type::ALPHABET, ch);
+        }
+        switch (ch)
+        {
+        case '(':
+            return Token(Token::operator_type::L_PARANTHESIS, ch);
+        case ')':
+            return Token(Token::operator_type::R_PARANTHESIS, ch);
+        case '*':
+            return Token(Token::operator_type::CLOSURE, ch, 4);
+        case '|':
+            return Token(Token::operator_type::UNION, ch, 1);
+        case '?':
+            return Token(Token::operator_type::ZERO_OR_MORE, ch, 3);
+        case '+':
+            return Token(Token::operator_type::ONE_OR_MORE, ch, 3);
+        case '.':
+            return Token(Token::operator_type::CONCAT, ch, 2);
+        default:
+            return Token();
+        }
+    }
+
     // The Operator stack will hold all of the operators that pass throughand respond to new operators by following
     // the rules we used in the previous section. The Output queue will be the final postfix notation.
-    template <size_t N> void calculate_postfix_from(_IN_ std::array<Token, N> const &arr)
+    template <typename Tokens> void calculate_postfix_from(_IN_ Tokens const &arr)
     {
 #ifdef LDEBUG
         PROFILE_FUNCTION();
@@ -167,14 +178,69 @@ struct RgxString
                     m_Output.push_back(m_TokenStack.top().m_Ch);
                     m_TokenStack.pop();
                 }
+                if (m_TokenStack.empty())
+                {
+                    set_error("unbalanced ')'");
+                    continue;
+                }
                 m_TokenStack.pop();
             }
         }
         while (!m_TokenStack.empty())
         {
+            if (m_TokenStack.top().m_OpType == Token::operator_type::L_PARANTHESIS)
+            {
+                set_error("unbalanced '('");
+            }
             m_Output.push_back(m_TokenStack.top().m_Ch);
             m_TokenStack.pop();
         }
+        check_operands();
+    }
+
+    // Replays the postfix output on an operand counter, the way make_nfa will consume it.
+    void check_operands()
+    {
+        size_t operands{0};
+        for (auto ch : m_Output)
+        {
+            if (is_letter(ch))
+            {
+                ++operands;
+            }
+            else if (ch == '.' || ch == '|')
+            {
+                if (operands < 2)
+                {
+                    return set_error(std::string("missing operand for '") + ch + "'");
+                }
+                --operands;
+            }
+            else if (ch == '*' || ch == '+' || ch == '?')
+            {
+                if (operands < 1)
+                {
+                    return set_error(std::string("missing operand for '") + ch + "'");
+                }
+            }
+        }
+        if (operands == 0)
+        {
+            set_error("empty pattern");
+        }
+        else if (operands > 1)
+        {
+            set_error("missing operator, concatenation is written as '.'");
+        }
+    }
+
+    // Keeps the first error, later ones are usually caused by it.
+    void set_error(std::string &&error)
+    {
+        if (m_Error.empty())
+        {
+            m_Error = std::move(error);
+        }
     }
 
     bool is_letter(const char ch)
@@ -185,9 +251,10 @@ struct RgxString
   private:
     std::stack<Token> m_TokenStack;
     DQType m_Output;
+    std::string m_Error;
 };
 
-std::ostream &operator<<(std::ostream &os, RgxString &rString)
+inline std::ostream &operator<<(std::ostream &os, RgxString &rString)
 {
     for (auto &ch : rString)
     {
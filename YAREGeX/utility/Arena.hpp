@@ -0,0 +1,126 @@
+#pragma once
+
+/**
+ * Bump allocator for NFA states
+ * Hands out memory from large blocks and releases all of it at once. make_state allocates from the arena
+ * installed on the calling thread by Arena::Scope, so a thread building many NFAs neither contends on the
+ * global heap nor scatters the states of one NFA over it.
+ *
+ * Author   : Bora Ilgar
+ * Version  : 0.9.1
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace lambda
+{
+
+// Not thread-safe: an arena belongs to the thread that installed it. Every object allocated from it holds
+// a reference through ArenaAllocator, so the blocks outlive the thread and are freed with the last object.
+// NFA states with loops keep each other alive, release such an NFA with detail::release_nfa (RgxProgram does).
+struct Arena
+{
+    static constexpr size_t BlockSize = 64 * 1024;
+
+    Arena() = default;
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    void *allocate(size_t bytes, size_t align)
+    {
+        size_t offset = (m_Used + align - 1) / align * align;
+        if (m_Blocks.empty() || offset + bytes > m_BlockSize)
+        {
+            // new[] memory is aligned for any fundamental type, oversized requests get a block of their own
+            m_BlockSize = std::max(BlockSize, bytes);
+            m_Blocks.emplace_back(new char[m_BlockSize]);
+            offset = 0;
+        }
+        m_Used = offset + bytes;
+        m_Allocated += bytes;
+        return m_Blocks.back().get() + offset;
+    }
+
+    // Bytes handed out so far.
+    size_t bytes_allocated() const
+    {
+        return m_Allocated;
+    }
+
+    size_t block_count() const
+    {
+        return m_Blocks.size();
+    }
+
+    // Installs arena as the current arena of this thread for the lifetime of the scope.
+    struct Scope
+    {
+        explicit Scope(std::shared_ptr<Arena> arena) : m_Previous(std::move(current_slot()))
+        {
+            current_slot() = std::move(arena);
+        }
+        ~Scope()
+        {
+            current_slot() = std::move(m_Previous);
+        }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+      private:
+        std::shared_ptr<Arena> m_Previous;
+    };
+
+    // Arena of the calling thread, null outside of a Scope.
+    static const std::shared_ptr<Arena> &current()
+    {
+        return current_slot();
+    }
+
+  private:
+    static std::shared_ptr<Arena> &current_slot()
+    {
+        thread_local std::shared_ptr<Arena> sCurrent;
+        return sCurrent;
+    }
+
+  private:
+    std::vector<std::unique_ptr<char[]>> m_Blocks;
+    size_t m_BlockSize{0}, m_Used{0}, m_Allocated{0};
+};
+
+// Allocator for std::allocate_shared. Deallocation is a no-op, the arena frees everything when it goes away.
+template <typename T> struct ArenaAllocator
+{
+    using value_type = T;
+
+    explicit ArenaAllocator(std::shared_ptr<Arena> arena) : m_Arena(std::move(arena))
+    {
+    }
+    template <typename U> ArenaAllocator(const ArenaAllocator<U> &other) : m_Arena(other.m_Arena)
+    {
+    }
+
+    T *allocate(size_t count)
+    {
+        return static_cast<T *>(m_Arena->allocate(count * sizeof(T), alignof(T)));
+    }
+    void deallocate(T *, size_t)
+    {
+    }
+
+    template <typename U> bool operator==(const ArenaAllocator<U> &other) const
+    {
+        return m_Arena == other.m_Arena;
+    }
+    template <typename U> bool operator!=(const ArenaAllocator<U> &other) const
+    {
+        return m_Arena != other.m_Arena;
+    }
+
+    std::shared_ptr<Arena> m_Arena;
+};
+
+} // namespace lambda
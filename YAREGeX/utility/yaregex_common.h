@@ -1,11 +1,17 @@
 #pragma once
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <deque>
 #include <map>
+#include <memory>
 #include <ostream>
 #include <stack>
+#include <stdexcept>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #ifdef LDEBUG